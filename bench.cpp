@@ -0,0 +1,142 @@
+#include "grid.h"
+#include "solver.h"
+#include "game_runner.h"
+#include "solver_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Plays games without the ui and reports how fast and how well the solver plays.
+ *
+ * usage: bench [height width bombs [games [threads [seed]]]]
+ *        bench height width bombs replay seed
+ *
+ * Games are played by a `game_runner` on `threads` threads (one per core by default), seeded from
+ * `seed` (random by default). The seeds of the first games lost are printed, and any of them can be
+ * played again with `replay`, which prints the work its solver did as JSON (see `solver_stats`).
+ **/
+
+namespace {
+
+    /**most seeds of lost games printed**/
+    constexpr size_t LOST_SEEDS_SHOWN = 5;
+
+    /**Returns the `p`th percentile of `samples`, which is reordered**/
+    double percentile(std::vector<float>& samples, double p) {
+        if(samples.empty())
+            return 0;
+        size_t rank = std::min(samples.size() - 1, size_t(p / 100 * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    void print_latency(const char* name, std::vector<float>& samples) {
+        printf("%-22s p50 %9.1f  p95 %9.1f  p99 %9.1f  (%zu calls)\n", name,
+            percentile(samples, 50), percentile(samples, 95), percentile(samples, 99), samples.size());
+    }
+
+    void print_stats(const ms::solver_stats& stats) {
+        printf("%-22s %10s %12s %12s\n", "phase", "calls", "total ms", "us per call");
+        for(unsigned p = 0; p < ms::solver_stats::PHASE_COUNT; ++p) {
+            const ms::solver_stats::phase_totals& totals = stats.get(ms::solver_stats::phase(p));
+            printf("%-22s %10llu %12.1f %12.2f\n", ms::solver_stats::name(ms::solver_stats::phase(p)),
+                (unsigned long long) totals.calls, totals.nanoseconds / 1e6,
+                totals.calls > 0 ? totals.nanoseconds / 1e3 / totals.calls : 0.0);
+        }
+        for(unsigned c = 0; c < ms::solver_stats::COUNTER_COUNT; ++c) {
+            printf("%-22s %10llu\n", ms::solver_stats::name(ms::solver_stats::counter(c)),
+                (unsigned long long) stats.get(ms::solver_stats::counter(c)));
+        }
+    }
+
+    const char* state_name(enum ms::grid::gamestate state) {
+        switch(state) {
+        case ms::grid::WON: return "won";
+        case ms::grid::LOST: return "lost";
+        case ms::grid::RUNNING: return "running";
+        default: return "new";
+        }
+    }
+
+}
+
+int main(int argc, char ** argv) {
+    int height = 16, width = 16, bombs = 40, games = 1000, threads = 0;
+    std::uint64_t seed = ms::grid::random_seed();
+    bool replay = false;
+
+    if(argc > 3) {
+        try {
+            height = std::stoi(argv[1]);
+            width  = std::stoi(argv[2]);
+            bombs  = std::stoi(argv[3]);
+            if(argc > 5 && std::string(argv[4]) == "replay") {
+                replay = true;
+                seed = std::stoull(argv[5]);
+            } else {
+                if(argc > 4)
+                    games = std::stoi(argv[4]);
+                if(argc > 5)
+                    threads = std::stoi(argv[5]);
+                if(argc > 6)
+                    seed = std::stoull(argv[6]);
+            }
+        } catch (std::exception&) {
+            fprintf(stderr, "usage: %s [height width bombs [games [threads [seed]]]]\n"
+                "       %s height width bombs replay seed\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    ms::game_runner runner(height, width, bombs);
+    runner.set_threads(threads);
+    runner.set_record_latency(true);
+
+    if(replay) {
+        ms::game_runner::game_result result = runner.play(seed);
+        printf("%dx%d with %d bombs, seed %llu: %s after %u moves (%u guesses)\n", height, width, bombs,
+            (unsigned long long) seed, state_name(result.state), result.moves, result.guesses);
+        printf("%s\n", result.stats.to_json().c_str());
+        return 0;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<ms::game_runner::game_result> results = runner.run(games, seed);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<float> certain_latency, guess_latency;
+    std::vector<std::uint64_t> lost;
+    ms::solver_stats stats;
+    int won = 0, guesses = 0;
+    for(ms::game_runner::game_result& result : results) {
+        if(result.state == ms::grid::WON)
+            ++won;
+        else if(lost.size() < LOST_SEEDS_SHOWN)
+            lost.push_back(result.seed);
+        guesses += result.guesses;
+        stats.merge(result.stats);
+        certain_latency.insert(certain_latency.end(), result.certain_latency.begin(), result.certain_latency.end());
+        guess_latency.insert(guess_latency.end(), result.guess_latency.begin(), result.guess_latency.end());
+    }
+
+    printf("%dx%d with %d bombs, %d games on %u threads in %.3f s, seed %llu\n", height, width, bombs, games,
+        runner.threads(), seconds, (unsigned long long) seed);
+    printf("games/sec              %.1f\n", games / seconds);
+    printf("win rate               %.2f%% (%d/%d)\n", games > 0 ? 100.0 * won / games : 0.0, won, games);
+    printf("guesses                %d (%.2f per game, including the first move)\n", guesses, games > 0 ? double(guesses) / games : 0.0);
+    printf("latency in microseconds\n");
+    print_latency("step_certain()", certain_latency);
+    print_latency("step() when guessing", guess_latency);
+    printf("solver work over all games (phases nest, see solver_stats)\n");
+    print_stats(stats);
+    if(!lost.empty()) {
+        printf("seeds of games lost   ");
+        for(std::uint64_t game : lost)
+            printf(" %llu", (unsigned long long) game);
+        printf("\n");
+    }
+}
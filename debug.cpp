@@ -0,0 +1,181 @@
+#include "debug.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace dbg {
+
+	namespace {
+
+		/**
+		 * A bounded queue of traces that any number of threads push to without locking, and a
+		 * thread that writes them out every `FLUSH_INTERVAL`. Each slot holds a sequence number
+		 * telling whether it is free for the push at a position or holds the trace to pop there.
+		 **/
+		class trace_ring {
+		public:
+			static constexpr std::size_t CAPACITY = 1 << 14;
+			static constexpr std::chrono::milliseconds FLUSH_INTERVAL{ 10 };
+
+			trace_ring() : slots(new slot[CAPACITY]) {
+				for(std::size_t i = 0; i < CAPACITY; ++i)
+					slots[i].sequence.store(i, std::memory_order_relaxed);
+				flusher = std::thread([this]() {
+					std::unique_lock<std::mutex> lock(sleep_mutex);
+					while(!stopping) {
+						wake.wait_for(lock, FLUSH_INTERVAL);
+						flush();
+					}
+				});
+			}
+
+			~trace_ring() {
+				{
+					std::lock_guard<std::mutex> lock(sleep_mutex);
+					stopping = true;
+				}
+				wake.notify_one();
+				flusher.join();
+				flush();
+			}
+
+			/**Adds a trace, or drops it if the ring is full. Never blocks.**/
+			void push(const char* text, std::size_t length) {
+				length = std::min(length, MESSAGE_SIZE);
+				std::size_t position = tail.load(std::memory_order_relaxed);
+				slot* s;
+				while(true) {
+					s = &slots[position & (CAPACITY - 1)];
+					std::size_t sequence = s->sequence.load(std::memory_order_acquire);
+					std::intptr_t difference = std::intptr_t(sequence) - std::intptr_t(position);
+					if(difference == 0) {
+						if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+							break;
+					} else if(difference < 0) {
+						dropped.fetch_add(1, std::memory_order_relaxed);
+						return;
+					} else {
+						position = tail.load(std::memory_order_relaxed);
+					}
+				}
+				std::memcpy(s->text, text, length);
+				s->length = length;
+				s->sequence.store(position + 1, std::memory_order_release);
+			}
+
+			/**Writes out every trace pushed so far, in order.**/
+			void flush() {
+				std::lock_guard<std::mutex> lock(pop_mutex);
+				bool wrote = false;
+				while(true) {
+					slot& s = slots[head & (CAPACITY - 1)];
+					if(s.sequence.load(std::memory_order_acquire) != head + 1)
+						break;
+					if(out)
+						out->write(s.text, s.length);
+					s.sequence.store(head + CAPACITY, std::memory_order_release);
+					++head;
+					wrote = true;
+				}
+				std::size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+				if(lost > 0 && out) {
+					*out << "[" << lost << " traces dropped]\n";
+					total_dropped += lost;
+				}
+				if(wrote && out)
+					out->flush();
+			}
+
+			void set_output(std::ostream* to) {
+				std::lock_guard<std::mutex> lock(pop_mutex);
+				out = to;
+			}
+
+			std::size_t dropped_count() {
+				std::lock_guard<std::mutex> lock(pop_mutex);
+				return total_dropped + dropped.load(std::memory_order_relaxed);
+			}
+
+		private:
+			struct slot {
+				std::atomic<std::size_t> sequence;
+				std::size_t length;
+				char text[MESSAGE_SIZE];
+			};
+
+			std::unique_ptr<slot[]> slots;
+			std::atomic<std::size_t> tail{ 0 };
+			std::atomic<std::size_t> dropped{ 0 };
+
+			//only used while holding pop_mutex
+			std::mutex pop_mutex;
+			std::size_t head = 0;
+			std::size_t total_dropped = 0;
+			std::ostream* out = &std::cout;
+
+			std::mutex sleep_mutex;
+			std::condition_variable wake;
+			bool stopping = false;
+			std::thread flusher;
+		};
+
+		/**Returns the ring, starting its thread on the first call.**/
+		trace_ring& ring() {
+			static trace_ring instance;
+			return instance;
+		}
+
+	}
+
+	/**
+	 * Returns this thread's line, emptied, to format a trace into.
+	 **/
+	trace_line& begin_trace() {
+		thread_local trace_line line;
+		line.reset();
+		return line;
+	}
+
+	/**
+	 * Pushes the trace formatted into `line` onto the ring.
+	 **/
+	void end_trace(trace_line& line) {
+		trace(line.data(), line.size());
+	}
+
+	/**
+	 * Pushes a trace onto the ring, cut to `MESSAGE_SIZE` characters. Dropped if the ring is full.
+	 **/
+	void trace(const char* text, std::size_t length) {
+		ring().push(text, length);
+	}
+
+	/**
+	 * Writes out every trace pushed so far, without waiting for the background thread.
+	 **/
+	void flush_trace() {
+		ring().flush();
+	}
+
+	/**
+	 * Sets the stream traces are written to, `std::cout` by default. Traces are discarded if `out` is null.
+	 **/
+	void set_trace_output(std::ostream* out) {
+		ring().set_output(out);
+	}
+
+	/**
+	 * Returns the number of traces dropped because the ring was full.
+	 **/
+	std::size_t dropped_traces() {
+		return ring().dropped_count();
+	}
+
+}
@@ -2,31 +2,67 @@
 #ifndef MS_DEBUG_H
 #define MS_DEBUG_H
 
-#include <iostream>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
 
-namespace dbg {
-
-#if __cpp_inline_variables >= 201606
-#define STORAGE_SPEC inline
+/**
+ * Traces are written with `MS_TRACE(level, message)`, where `message` is anything that can be
+ * streamed into a `std::ostream`, such as `"opened: " << cell << "\n"`.
+ *
+ * Levels above `MS_TRACE_LEVEL` (`DEBUG` if defined, otherwise 0) compile to nothing: the message
+ * is type checked but never evaluated. Level 1 traces each move and pass of the solver, and level 2
+ * adds the progress of every iteration.
+ *
+ * Enabled traces are formatted into a fixed buffer on the calling thread and pushed onto a
+ * lock-free ring, which a background thread writes out. A trace never blocks or allocates: if the
+ * ring is full it is dropped and counted, and a trace longer than `MESSAGE_SIZE` is cut short.
+ **/
+#ifndef MS_TRACE_LEVEL
+#if defined(DEBUG)
+#define MS_TRACE_LEVEL DEBUG
 #else
-#define STORAGE_SPEC static
+#define MS_TRACE_LEVEL 0
 #endif
-
-#if defined(DEBUG) && (DEBUG == 1) && !(DEBUG == 0)
-	STORAGE_SPEC std::ostream& cout = std::cout;	
-#else
-	STORAGE_SPEC std::ostream cout(0);
 #endif
 
-#if defined(DEBUG) && (DEBUG == 2) && !(DEBUG == 0)
-	STORAGE_SPEC std::ostream& cout2 = std::cout;
-#else
-	STORAGE_SPEC std::ostream cout2(0);
-#endif
+#define MS_TRACE(level, message) \
+	do { \
+		if constexpr((level) <= ::dbg::trace_level) { \
+			::dbg::trace_line& ms_trace_line_ = ::dbg::begin_trace(); \
+			ms_trace_line_ << message; \
+			::dbg::end_trace(ms_trace_line_); \
+		} \
+	} while(0)
+
+namespace dbg {
+
+	constexpr int trace_level = MS_TRACE_LEVEL;
+	/**the longest trace kept, in characters**/
+	constexpr std::size_t MESSAGE_SIZE = 120;
+
+	/**
+	 * A stream that formats one trace into a fixed buffer, ignoring anything past its end.
+	 **/
+	class trace_line : private std::streambuf, public std::ostream {
+	public:
+		trace_line() : std::ostream(this) { reset(); }
+		/**Empties the buffer and clears the state of the stream.**/
+		void reset() { setp(text, text + MESSAGE_SIZE); clear(); }
+		const char* data() const { return pbase(); }
+		std::size_t size() const { return pptr() - pbase(); }
+	private:
+		char text[MESSAGE_SIZE];
+	};
 
-#undef STORAGE_SPEC
+	trace_line& begin_trace();
+	void end_trace(trace_line& line);
+	void trace(const char* text, std::size_t length);
+	void flush_trace();
+	void set_trace_output(std::ostream* out);
+	std::size_t dropped_traces();
 
 }
 
 
-#endif //MS_DEBUG_H
\ No newline at end of file
+#endif //MS_DEBUG_H
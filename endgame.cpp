@@ -0,0 +1,255 @@
+#include "endgame.h"
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+
+namespace ms {
+
+namespace {
+
+    unsigned popcount(std::uint32_t x) {
+        return std::bitset<32>(x).count();
+    }
+
+    /**the splitmix64 finalizer, used as the key of a layout in the hash of a set of layouts**/
+    std::uint64_t mix(std::uint64_t x) {
+        x += 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+}
+
+/**
+ * Searches the hidden cells of `g` for the move with the highest chance of winning.
+ *
+ * Returns false if there are more than `MAX_CELLS` hidden cells, no layout agrees with the grid,
+ * no hidden cell can be safe, or the search spent `node_budget` or passed `deadline` before it
+ * was done. Without a deadline, the result depends only on the grid and the budget.
+ *
+ * Complexity exponential in the number of hidden cells, bounded by the node budget
+ **/
+bool endgame::solve(const grid& g, size_t node_budget, std::chrono::steady_clock::time_point deadline) {
+    this->node_budget = node_budget;
+    this->deadline = deadline;
+    exhausted = deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() > deadline;
+    nodes = 0;
+    spent_calls = 0;
+    cells.clear();
+    neighbors.clear();
+    memo.clear();
+    constraints.clear();
+    layout_count = 0;
+
+    std::vector<int> index(g.height() * g.width(), -1);
+    for(unsigned r = 0; r < g.height(); ++r) {
+        for(unsigned c = 0; c < g.width(); ++c) {
+            grid::cell value = g.get(r,c);
+            if(value == grid::ms_hidden || value == grid::ms_question) {
+                if(cells.size() == MAX_CELLS)
+                    return false;
+                index[r * g.width() + c] = cells.size();
+                cells.push_back(rc_coord(r,c));
+            }
+        }
+    }
+    if(cells.empty())
+        return false;
+
+    cell_constraints.assign(cells.size(), std::vector<unsigned>());
+    for(unsigned r = 0; r < g.height(); ++r) {
+        for(unsigned c = 0; c < g.width(); ++c) {
+            grid::cell value = g.get(r,c);
+            if(value < grid::ms_0 || value > grid::ms_8)
+                continue;
+            layout hidden = 0;
+            unsigned flags = 0;
+            for(int dr = -1; dr <= 1; ++dr) {
+                for(int dc = -1; dc <= 1; ++dc) {
+                    if((dr != 0 || dc != 0) && g.iscontained(r + dr, c + dc)) {
+                        grid::cell neighbor = g.get(r + dr, c + dc);
+                        if(neighbor == grid::ms_flag)
+                            ++flags;
+                        else if(neighbor == grid::ms_hidden || neighbor == grid::ms_question)
+                            hidden |= layout(1) << index[(r + dr) * g.width() + c + dc];
+                    }
+                }
+            }
+            if(flags > unsigned(value))
+                return false;
+            if(hidden == 0)
+                continue;
+            for(unsigned i = 0; i < cells.size(); ++i) {
+                if(hidden >> i & 1)
+                    cell_constraints[i].push_back(constraints.size());
+            }
+            constraints.push_back(constraint{ hidden, value - flags });
+        }
+    }
+
+    for(unsigned i = 0; i < cells.size(); ++i) {
+        layout around = 0;
+        for(unsigned j = 0; j < cells.size(); ++j) {
+            if(j != i && std::max(cells[i].row, cells[j].row) - std::min(cells[i].row, cells[j].row) <= 1 &&
+                std::max(cells[i].col, cells[j].col) - std::min(cells[i].col, cells[j].col) <= 1)
+                around |= layout(1) << j;
+        }
+        neighbors.push_back(around);
+    }
+
+    unassigned.clear();
+    for(const constraint& con : constraints)
+        unassigned.push_back(popcount(con.cells));
+    std::vector<layout> layouts;
+    unsigned bombs = g.remaining_bombs();
+    if(bombs <= cells.size())
+        enumerate(0, 0, bombs, layouts);
+    if(exhausted || layouts.empty())
+        return false;
+    layout_count = layouts.size();
+
+    size_t best = cells.size();
+    probability = win_chance(layouts, &best);
+    if(exhausted || best == cells.size())
+        return false;
+    move = cells[best];
+    return true;
+}
+
+/**
+ * Adds `work` to the nodes searched, and marks the search exhausted once the node budget is spent
+ * or, looking at the clock every `CLOCK_INTERVAL` calls, the deadline has passed.
+ *
+ * Returns true if the search is exhausted.
+ **/
+bool endgame::spend(size_t work) {
+    nodes += work;
+    if(nodes > node_budget)
+        exhausted = true;
+    else if((++spent_calls & (CLOCK_INTERVAL - 1)) == 0 && deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() > deadline)
+        exhausted = true;
+    return exhausted;
+}
+
+/**
+ * Adds every layout with `bombs` more bombs in the cells from `pos` on, that meets every constraint,
+ * to `out`. Backtracks as soon as a constraint can no longer be met.
+ **/
+void endgame::enumerate(size_t pos, layout current, unsigned bombs, std::vector<layout>& out) {
+    if(exhausted || spend(1))
+        return;
+    if(bombs > cells.size() - pos)
+        return;
+    if(pos == cells.size()) {
+        out.push_back(current);
+        return;
+    }
+    for(unsigned v = 0; v <= 1; ++v) {
+        if(v == 1 && bombs == 0)
+            break;
+        bool fits = true;
+        for(unsigned c : cell_constraints[pos]) {
+            //the bombs left must fit in the cells left after this one
+            if(v > constraints[c].bombs || constraints[c].bombs - v > unassigned[c] - 1)
+                fits = false;
+        }
+        if(!fits)
+            continue;
+        for(unsigned c : cell_constraints[pos]) {
+            constraints[c].bombs -= v;
+            --unassigned[c];
+        }
+        enumerate(pos + 1, current | layout(v) << pos, bombs - v, out);
+        for(unsigned c : cell_constraints[pos]) {
+            constraints[c].bombs += v;
+            ++unassigned[c];
+        }
+    }
+}
+
+/**
+ * Returns the chance of winning from a set of layouts (each equally likely) and, if `best_cell` is
+ * not null, sets it to the index of the best cell to open.
+ *
+ * Cells are tried from the most to the least likely to be safe, and the search stops once no
+ * remaining cell is safe often enough to beat the best found. Cells that are safe in every layout
+ * and show the same number in all of them give no information and are skipped.
+ **/
+double endgame::win_chance(const std::vector<layout>& layouts, size_t* best_cell) {
+    if(layouts.size() == 1) {
+        if(best_cell != nullptr) {
+            for(size_t i = 0; i < cells.size(); ++i) {
+                if(!(layouts.front() >> i & 1)) {
+                    *best_cell = i;
+                    return 1;
+                }
+            }
+            return 0;
+        }
+        return 1;
+    }
+
+    std::uint64_t key = 0;
+    for(layout l : layouts)
+        key ^= mix(l);
+    if(best_cell == nullptr) {
+        std::unordered_map<std::uint64_t, double>::const_iterator found = memo.find(key);
+        if(found != memo.end())
+            return found->second;
+    }
+    if(exhausted || spend(layouts.size()))
+        return 0;
+
+    std::vector<size_t> safe(cells.size(), 0);
+    for(layout l : layouts) {
+        for(size_t i = 0; i < cells.size(); ++i)
+            safe[i] += !(l >> i & 1);
+    }
+    std::vector<size_t> order(cells.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return safe[a] > safe[b]; });
+
+    double best = 0;
+    size_t best_index = order.front();
+    std::vector<layout> shown[9];
+    for(size_t i : order) {
+        if(safe[i] == 0 || double(safe[i]) / layouts.size() <= best)
+            break;
+        for(std::vector<layout>& v : shown)
+            v.clear();
+        for(layout l : layouts) {
+            if(!(l >> i & 1))
+                shown[popcount(l & neighbors[i])].push_back(l);
+        }
+        bool informative = true;
+        for(const std::vector<layout>& v : shown) {
+            if(v.size() == layouts.size())
+                informative = false;
+        }
+        if(!informative)
+            continue;
+        double chance = 0;
+        for(const std::vector<layout>& v : shown) {
+            if(!v.empty())
+                chance += v.size() * win_chance(v, nullptr);
+            if(exhausted)
+                return 0;
+        }
+        chance /= layouts.size();
+        if(chance > best) {
+            best = chance;
+            best_index = i;
+        }
+        if(best == 1)
+            break;
+    }
+
+    memo[key] = best;
+    if(best_cell != nullptr)
+        *best_cell = best_index;
+    return best;
+}
+
+}
@@ -0,0 +1,93 @@
+#ifndef MS_ENDGAME_H
+#define MS_ENDGAME_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "grid.h"
+#include "rc_coord.h"
+
+namespace ms {
+
+/**
+ * Finds the move with the highest chance of winning once few cells are left, by searching every
+ * layout of the remaining bombs and every number each cell could show.
+ *
+ * All layouts of the bombs left in the hidden cells that agree with the numbers on the grid are
+ * equally likely. Opening a cell splits them by the number it shows, and the chance of winning
+ * from a set of layouts is the best, over the cells, of the chance of each number times the chance
+ * of winning from the layouts showing it. A single layout is always won. The chance of winning
+ * from each set of layouts is memoized, since different orders of moves reach the same sets.
+ *
+ * Flagged cells are assumed to be bombs.
+ *
+ * The search is bounded by a budget of work, counted in backtracking nodes while enumerating the
+ * layouts and in layouts looked at while choosing moves, so that it stops at the same point on any
+ * machine. A wall clock deadline can be given as well, for interactive use.
+ **/
+class endgame {
+public:
+    /**most hidden cells searched, so that a layout fits in a `std::uint32_t`**/
+    static constexpr unsigned MAX_CELLS = 32;
+    /**work `solve` may spend by default, about 40 milliseconds on a desktop machine**/
+    static constexpr size_t DEFAULT_NODE_BUDGET = 1 << 17;
+
+    bool solve(const grid& g, size_t node_budget = DEFAULT_NODE_BUDGET,
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    /**Returns the cell to open with the highest chance of winning, as of the last successful call to `solve`.\n Complexity \f$O(1)\f$**/
+    rc_coord best_move() const { return move; }
+    /**Returns the chance of winning by opening `best_move()`.\n Complexity \f$O(1)\f$**/
+    double win_probability() const { return probability; }
+    /**Returns the number of layouts agreeing with the grid in the last call to `solve`.\n Complexity \f$O(1)\f$**/
+    size_t layouts() const { return layout_count; }
+    /**Returns the number of sets of layouts memoized in the last call to `solve`.\n Complexity \f$O(1)\f$**/
+    size_t positions() const { return memo.size(); }
+    /**Returns the work spent by the last call to `solve`, in the units of its node budget.\n Complexity \f$O(1)\f$**/
+    size_t nodes_searched() const { return nodes; }
+
+private:
+    typedef std::uint32_t layout;
+
+    /**a number on the grid next to hidden cells: the hidden cells next to it must hold `bombs` bombs**/
+    struct constraint {
+        layout cells;
+        /**bombs still to be placed in the constraint**/
+        unsigned bombs;
+    };
+
+    std::vector<rc_coord> cells;
+    /**the hidden cells next to each cell of `cells`**/
+    std::vector<layout> neighbors;
+
+    //scratch space for `enumerate`
+    std::vector<constraint> constraints;
+    std::vector<std::vector<unsigned>> cell_constraints;
+    /**the number of cells of each constraint not assigned yet**/
+    std::vector<unsigned> unassigned;
+
+    std::unordered_map<std::uint64_t, double> memo;
+    size_t nodes;
+    size_t node_budget;
+    /**calls to `spend`, to look at the clock only every `CLOCK_INTERVAL` of them**/
+    size_t spent_calls;
+    std::chrono::steady_clock::time_point deadline;
+    /**set once the budget is spent or the deadline has passed**/
+    bool exhausted;
+
+    rc_coord move = BAD_RC_COORD;
+    double probability = 0;
+    size_t layout_count = 0;
+
+    static constexpr size_t CLOCK_INTERVAL = 1024;
+
+    bool spend(size_t work);
+    void enumerate(size_t pos, layout current, unsigned bombs, std::vector<layout>& out);
+    double win_chance(const std::vector<layout>& layouts, size_t* best_cell);
+};
+
+}
+
+#endif //MS_ENDGAME_H
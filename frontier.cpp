@@ -0,0 +1,135 @@
+#include "frontier.h"
+#include <numeric>
+
+namespace ms {
+
+/**
+ * Initializes a frontier where every cell of a grid with the given dimensions is its own component
+ *
+ * Complexity \f$O(N)\f$ where \f$N\f$ is the number of cells in the grid
+ **/
+frontier::frontier(unsigned height, unsigned width) :
+    width(width), parents(height * width), sizes(height * width, 1) {
+    std::iota(parents.begin(), parents.end(), 0);
+}
+
+/**
+ * Joins the components of all cells in the region.
+ *
+ * Complexity \f$O(M \cdot \alpha(N))\f$ amortized, where \f$M\f$ is the size of the region
+ **/
+void frontier::link(const region& reg) {
+    region::const_iterator it = reg.begin();
+    if(it == reg.end())
+        return;
+    std::uint32_t first = index_of(*it);
+    for(++it; it != reg.end(); ++it) {
+        unite(first, index_of(*it));
+    }
+}
+
+/**
+ * Discards all components and links every region of `regions` again, splitting components
+ * that are no longer connected.
+ *
+ * Complexity \f$O(N + M \cdot \alpha(N))\f$ where \f$M\f$ is the total size of all regions
+ **/
+void frontier::build(const region_set& regions) {
+    clear();
+    for(const region& reg : regions) {
+        link(reg);
+    }
+}
+
+/**
+ * Makes every cell its own component again.
+ *
+ * Complexity \f$O(N)\f$ where \f$N\f$ is the number of cells in the grid
+ **/
+void frontier::clear() {
+    if(checkpoints.empty()) {
+        std::iota(parents.begin(), parents.end(), 0);
+        std::fill(sizes.begin(), sizes.end(), 1);
+        return;
+    }
+    for(std::uint32_t i = 0; i < parents.size(); ++i) {
+        if(parents[i] != i)
+            set_parent(i, i);
+        if(sizes[i] != 1)
+            set_size(i, 1);
+    }
+}
+
+/**
+ * Returns an identifier of the component containing the cell. Two cells are in the same
+ * component iff their identifiers are equal. Identifiers can change when components are joined.
+ *
+ * Complexity \f$O(\alpha(N))\f$ amortized
+ **/
+unsigned frontier::find(rc_coord cell) {
+    return find_root(index_of(cell));
+}
+
+std::uint32_t frontier::find_root(std::uint32_t index) {
+    //path halving: point every other cell on the path at its grandparent. Cells whose parent is the
+    //root are left alone, so a checkpoint only records the parents that actually change
+    while(parents[index] != index) {
+        std::uint32_t grandparent = parents[parents[index]];
+        if(grandparent != parents[index])
+            set_parent(index, grandparent);
+        index = parents[index];
+    }
+    return index;
+}
+
+/**
+ * Joins two components, attaching the smaller one below the larger one.
+ **/
+void frontier::unite(std::uint32_t a, std::uint32_t b) {
+    a = find_root(a);
+    b = find_root(b);
+    if(a == b)
+        return;
+    if(sizes[a] < sizes[b])
+        std::swap(a, b);
+    set_parent(b, a);
+    set_size(a, sizes[a] + sizes[b]);
+}
+
+/**
+ * Starts recording changes so that they can be undone by `rollback`. Checkpoints nest.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+void frontier::checkpoint() {
+    checkpoints.push_back(trail.size());
+}
+
+/**
+ * Undoes every change since the most recent checkpoint, and removes the checkpoint.
+ *
+ * Complexity \f$O(M)\f$ where \f$M\f$ is the number of changes since the checkpoint
+ **/
+void frontier::rollback() {
+    assert(!checkpoints.empty());
+    while(trail.size() > checkpoints.back()) {
+        const trail_entry& entry = trail.back();
+        (entry.is_size ? sizes : parents)[entry.index] = entry.value;
+        trail.pop_back();
+    }
+    checkpoints.pop_back();
+}
+
+void frontier::set_parent(std::uint32_t index, std::uint32_t parent) {
+    if(!checkpoints.empty())
+        trail.push_back(trail_entry{ index, parents[index], false });
+    parents[index] = parent;
+}
+
+void frontier::set_size(std::uint32_t index, std::uint32_t size) {
+    if(!checkpoints.empty())
+        trail.push_back(trail_entry{ index, sizes[index], true });
+    sizes[index] = size;
+}
+
+}
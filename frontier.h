@@ -0,0 +1,66 @@
+#ifndef MS_FRONTIER_H
+#define MS_FRONTIER_H
+
+#include <cstdint>
+#include <vector>
+#include "rc_coord.h"
+#include "region.h"
+#include "region_set.h"
+
+namespace ms {
+
+/**
+ * Splits the hidden cells next to opened cells (the frontier) into connected components, where
+ * two cells are connected if some region contains both. Regions in different components share
+ * no cells, so deductions and probabilities of one component never depend on another.
+ *
+ * Components are kept in a union-find over all cells of the grid. Linking a region joins the
+ * components of its cells. Components are never split when cells are resolved, so a component
+ * may hold several parts that are no longer connected until `build` is called again. Cells that
+ * were never linked are each their own component.
+ *
+ * Changes can be undone with `checkpoint` and `rollback`.
+ **/
+class frontier {
+public:
+    frontier(unsigned height, unsigned width);
+
+    void link(const region&);
+    void build(const region_set&);
+    void clear();
+
+    void checkpoint();
+    void rollback();
+
+    unsigned find(rc_coord);
+    /**Returns true if both cells are in the same component.\n Complexity \f$O(\alpha(N))\f$ amortized**/
+    bool connected(rc_coord a, rc_coord b) { return find(a) == find(b); }
+    /**Returns the number of cells in the component of a cell.\n Complexity \f$O(\alpha(N))\f$ amortized**/
+    unsigned component_size(rc_coord cell) { return sizes[find(cell)]; }
+
+private:
+    unsigned width;
+    /**parent of each cell by `row * width + col`, roots are their own parent**/
+    std::vector<std::uint32_t> parents;
+    /**number of cells in the component, only kept up to date for roots**/
+    std::vector<std::uint32_t> sizes;
+
+    /**old values of `parents` (or `sizes` if `is_size`) changed while a checkpoint is active**/
+    struct trail_entry {
+        std::uint32_t index, value;
+        bool is_size;
+    };
+    std::vector<trail_entry> trail;
+    /**the size of `trail` at each active checkpoint**/
+    std::vector<size_t> checkpoints;
+
+    std::uint32_t index_of(rc_coord cell) const { return cell.row * width + cell.col; }
+    void set_parent(std::uint32_t index, std::uint32_t parent);
+    void set_size(std::uint32_t index, std::uint32_t size);
+    std::uint32_t find_root(std::uint32_t index);
+    void unite(std::uint32_t a, std::uint32_t b);
+};
+
+}
+
+#endif //MS_FRONTIER_H
@@ -0,0 +1,105 @@
+#include "game_runner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace ms {
+
+/**
+ * Initializes a runner for games of the given size, played on one thread per core.
+ **/
+game_runner::game_runner(unsigned height, unsigned width, unsigned bombs) :
+    height(height), width(width), bombs(bombs) {
+    set_threads(0);
+}
+
+/**
+ * Sets the number of threads games are played on, including the calling thread. `0` uses one
+ * thread per core. The results do not depend on the number of threads.
+ **/
+void game_runner::set_threads(unsigned threads) {
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    if(threads == this->threads())
+        return;
+    if(threads == 1)
+        pool.reset();
+    else
+        pool.reset(new thread_pool(threads));
+}
+
+/**
+ * Returns the seed of game `game` of a run with the given master seed: the `game`th output of a
+ * splitmix64 generator started at the master seed.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+std::uint64_t game_runner::game_seed(std::uint64_t master_seed, unsigned game) {
+    std::uint64_t x = master_seed + (game + 1) * 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Plays `games` games, seeded from `master_seed`, and returns their results in game order.
+ *
+ * If the setup function or a game throws, the exception is rethrown once every thread has stopped.
+ **/
+std::vector<game_runner::game_result> game_runner::run(unsigned games, std::uint64_t master_seed) {
+    std::vector<game_result> results(games);
+    std::atomic<unsigned> next{ 0 };
+    auto worker = [&](size_t, size_t, unsigned) {
+        for(unsigned game = next++; game < games; game = next++)
+            results[game] = play(game_seed(master_seed, game));
+    };
+    if(pool)
+        pool->parallel_for(pool->size(), worker);
+    else
+        worker(0, 1, 0);
+    return results;
+}
+
+/**
+ * Plays one game with a new solver seeded with `seed` until it is won or lost, the same way as
+ * `solver::solve`: one `step_certain` at a time, and a `step` only when no cell is certain.
+ *
+ * Safe to call from several threads at once if the setup function is.
+ **/
+game_runner::game_result game_runner::play(std::uint64_t seed) const {
+    typedef std::chrono::steady_clock clock;
+    game_result result;
+    result.seed = seed;
+
+    solver ai(height, width, bombs);
+    if(setup)
+        setup(ai);
+    ai.set_seed(seed);
+
+    while(true) {
+        clock::time_point start = clock::now();
+        rc_coord move = ai.step_certain();
+        if(record_latency)
+            result.certain_latency.push_back(std::chrono::duration<float, std::micro>(clock::now() - start).count());
+        if(move != BAD_RC_COORD) {
+            ++result.moves;
+            continue;
+        }
+        if(ai.gamestate() != grid::NEW && ai.gamestate() != grid::RUNNING)
+            break;
+
+        start = clock::now();
+        move = ai.step();
+        if(record_latency)
+            result.guess_latency.push_back(std::chrono::duration<float, std::micro>(clock::now() - start).count());
+        if(move == BAD_RC_COORD)
+            break;
+        ++result.moves;
+        ++result.guesses;
+    }
+    result.state = (enum grid::gamestate) ai.gamestate();
+    result.stats = ai.stats();
+    return result;
+}
+
+}
@@ -0,0 +1,66 @@
+#ifndef MS_GAME_RUNNER_H
+#define MS_GAME_RUNNER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "grid.h"
+#include "solver.h"
+#include "solver_stats.h"
+#include "thread_pool.h"
+
+namespace ms {
+
+/**
+ * Plays many games of one size with a new `solver` each, spread over several threads.
+ *
+ * Game `i` of a run is seeded with `game_seed(master_seed, i)` (see `solver::set_seed`), so a run
+ * is reproduced by its master seed, and any one game of it is replayed exactly by passing its seed
+ * to `play`, whatever the number of threads. Games are handed to the threads one at a time, and
+ * the results are returned in game order.
+ **/
+class game_runner {
+public:
+    /**the outcome of one game**/
+    struct game_result {
+        std::uint64_t seed = 0;
+        enum grid::gamestate state = grid::NEW;
+        /**cells opened or flagged by the solver**/
+        unsigned moves = 0;
+        /**moves made when no cell was certain, including the first move**/
+        unsigned guesses = 0;
+        /**microseconds spent in each call to `step_certain`, empty unless latencies are recorded**/
+        std::vector<float> certain_latency;
+        /**microseconds spent in each call to `step` when guessing, empty unless latencies are recorded**/
+        std::vector<float> guess_latency;
+        /**the work done by the solver over the game**/
+        solver_stats stats;
+    };
+    /**called on the solver of every game before it is seeded and played, to change its settings**/
+    typedef std::function<void(solver&)> setup_type;
+
+    game_runner(unsigned height, unsigned width, unsigned bombs);
+
+    std::vector<game_result> run(unsigned games, std::uint64_t master_seed);
+    game_result play(std::uint64_t seed) const;
+    static std::uint64_t game_seed(std::uint64_t master_seed, unsigned game);
+
+    void set_threads(unsigned threads);
+    /**Returns the number of threads games are played on, including the calling thread.\n Complexity \f$O(1)\f$**/
+    unsigned threads() const { return pool ? pool->size() : 1; }
+    void set_setup(setup_type setup) { this->setup = setup; }
+    /**Sets whether the time of each step is kept in the results.\n Complexity \f$O(1)\f$**/
+    void set_record_latency(bool record) { record_latency = record; }
+
+private:
+    unsigned height, width, bombs;
+    setup_type setup;
+    bool record_latency = false;
+    /**null when single threaded**/
+    std::unique_ptr<thread_pool> pool;
+};
+
+}
+
+#endif //MS_GAME_RUNNER_H
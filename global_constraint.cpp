@@ -0,0 +1,108 @@
+#include "global_constraint.h"
+#include <algorithm>
+
+namespace ms {
+
+/**
+ * Initializes the constraint for a grid with the given dimensions, with no hidden cells.
+ **/
+global_constraint::global_constraint(unsigned height, unsigned width) :
+    width(width), covered(height * width, 0) {}
+
+/**
+ * Chooses families of disjoint regions of `regions` and checks them against the number of hidden
+ * cells and bombs left, set by `update`. `covers` and `family` give the family of the deduction.
+ *
+ * Throws `bad_region_error` if the regions need more bombs or more safe cells than are left.
+ *
+ * Complexity \f$O(R \log R + N)\f$ where \f$R\f$ is the number of regions and \f$N\f$ the number of cells in them
+ **/
+global_constraint::deduction global_constraint::deduce(const region_set& regions) {
+    clear_family();
+    if(_bombs > _cells)
+        throw bad_region_error("more bombs left than hidden cells");
+    if(_cells == 0)
+        return NONE;
+    if(_bombs == 0)
+        return OUTSIDE_SAFE;
+    if(_bombs == _cells)
+        return OUTSIDE_BOMBS;
+
+    //the fewest bombs the family must hold
+    candidates.clear();
+    for(region_set::const_iterator it = regions.begin(); it != regions.end(); ++it) {
+        if(it->min() > 0)
+            candidates.emplace_back(it->min(), it.get_handle());
+    }
+    unsigned bombs = choose(regions);
+    if(bombs > _bombs)
+        throw bad_region_error("regions hold more bombs than are left");
+    if(bombs == _bombs && covered_cells.size() < _cells)
+        return OUTSIDE_SAFE;
+
+    //the fewest safe cells the family must hold
+    clear_family();
+    candidates.clear();
+    for(region_set::const_iterator it = regions.begin(); it != regions.end(); ++it) {
+        if(it->size() > it->max())
+            candidates.emplace_back(it->size() - it->max(), it.get_handle());
+    }
+    unsigned safe = choose(regions);
+    if(safe > _cells - _bombs)
+        throw bad_region_error("regions hold more safe cells than are left");
+    if(safe == _cells - _bombs && covered_cells.size() < _cells)
+        return OUTSIDE_BOMBS;
+
+    clear_family();
+    return NONE;
+}
+
+/**
+ * Empties the family.
+ *
+ * Complexity \f$O(N)\f$ where \f$N\f$ is the number of cells in the family
+ **/
+void global_constraint::clear_family() {
+    for(unsigned index : covered_cells)
+        covered[index] = 0;
+    covered_cells.clear();
+    _family.clear();
+}
+
+/**
+ * Adds the regions of `candidates` to the family greedily, highest weight first and smallest first
+ * among equal weights, skipping any region that shares a cell with the family. Returns the sum of
+ * the weights of the family.
+ *
+ * Complexity \f$O(R \log R + N)\f$
+ **/
+unsigned global_constraint::choose(const region_set& regions) {
+    std::sort(candidates.begin(), candidates.end(),
+        [&regions](const std::pair<unsigned, region_set::handle>& a, const std::pair<unsigned, region_set::handle>& b) {
+            if(a.first != b.first)
+                return a.first > b.first;
+            return regions[a.second].size() < regions[b.second].size();
+        });
+    unsigned total = 0;
+    for(const std::pair<unsigned, region_set::handle>& candidate : candidates) {
+        const region& reg = regions[candidate.second];
+        bool disjoint = true;
+        for(rc_coord cell : reg) {
+            if(covers(cell)) {
+                disjoint = false;
+                break;
+            }
+        }
+        if(!disjoint)
+            continue;
+        for(rc_coord cell : reg) {
+            covered[cell.row * width + cell.col] = 1;
+            covered_cells.push_back(cell.row * width + cell.col);
+        }
+        _family.push_back(candidate.second);
+        total += candidate.first;
+    }
+    return total;
+}
+
+}
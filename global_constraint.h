@@ -0,0 +1,73 @@
+#ifndef MS_GLOBAL_CONSTRAINT_H
+#define MS_GLOBAL_CONSTRAINT_H
+
+#include <vector>
+#include "grid.h"
+#include "rc_coord.h"
+#include "region.h"
+#include "region_set.h"
+
+namespace ms {
+
+/**
+ * The number of bombs left on a grid, as a constraint over all of its hidden cells. Only the
+ * number of hidden cells and the number of bombs left are kept, so the constraint costs the same
+ * however many cells are hidden, and it is never added to a `region_set` (where it would intersect
+ * every region and join every frontier component).
+ *
+ * Deductions are made against a family of disjoint regions: the regions of the family hold at
+ * least the sum of their minimums and at most the sum of their maximums, so if the minimums already
+ * account for every bomb left, every hidden cell outside of the family is safe, and if the cells
+ * the maximums leave safe account for every safe cell left, every hidden cell outside of the family
+ * is a bomb. The families are chosen greedily.
+ *
+ * Probabilities take the constraint into account by weighting the bombs of the frontier with the
+ * ways to place the rest in the unconstrained cells (see `probability_map`).
+ **/
+class global_constraint {
+public:
+    enum deduction {
+        /**nothing is known about the cells outside of the family**/
+        NONE,
+        /**every hidden cell outside of the family is safe**/
+        OUTSIDE_SAFE,
+        /**every hidden cell outside of the family is a bomb**/
+        OUTSIDE_BOMBS
+    };
+
+    global_constraint(unsigned height, unsigned width);
+
+    /**Sets the number of hidden cells and bombs left from the grid.\n Complexity \f$O(1)\f$**/
+    void update(const grid& g) { set(g.count_unopened(), g.remaining_bombs()); }
+    /**Sets the number of hidden cells (not counting flags) and the number of bombs left among them.\n Complexity \f$O(1)\f$**/
+    void set(unsigned cells, unsigned bombs) { _cells = cells; _bombs = bombs; }
+    unsigned cells() const { return _cells; }
+    unsigned bombs() const { return _bombs; }
+
+    deduction deduce(const region_set& regions);
+
+    /**Returns true if the cell is in a region of the family chosen by the last call to `deduce`.\n Complexity \f$O(1)\f$**/
+    bool covers(rc_coord cell) const { return covered[cell.row * width + cell.col]; }
+    /**Returns the family of disjoint regions chosen by the last call to `deduce`.\n Complexity \f$O(1)\f$**/
+    const std::vector<region_set::handle>& family() const { return _family; }
+
+private:
+    unsigned width;
+    unsigned _cells = 0;
+    unsigned _bombs = 0;
+
+    std::vector<region_set::handle> _family;
+    /**cells in the family by `row * width + col`**/
+    std::vector<unsigned char> covered;
+    /**the indices set in `covered`**/
+    std::vector<unsigned> covered_cells;
+    //scratch space for `choose`
+    std::vector<std::pair<unsigned, region_set::handle>> candidates;
+
+    void clear_family();
+    unsigned choose(const region_set& regions);
+};
+
+}
+
+#endif //MS_GLOBAL_CONSTRAINT_H
@@ -1,13 +1,34 @@
 #include "grid.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
 #include <vector>
-#include <time.h>
 #include "rc_coord.h"
 #include <cassert>
 
 
 namespace ms {
 
-	std::mt19937 grid::rng(time(NULL));
+	namespace {
+		/**the splitmix64 finalizer**/
+		std::uint64_t mix(std::uint64_t x) {
+			x += 0x9e3779b97f4a7c15;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+			return x ^ (x >> 31);
+		}
+	}
+
+	/**
+	 * Returns a seed that differs between calls, from the clock and a counter. Safe to call from
+	 * several threads at once.
+	 **/
+	std::uint64_t grid::random_seed() {
+		static std::atomic<std::uint64_t> calls{ 0 };
+		std::uint64_t now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+		return mix(now ^ mix(calls.fetch_add(1)));
+	}
 	
 	/**
 	 * Returns true if the given location is contained in the grid. Returns false otherwise.
@@ -19,56 +40,41 @@ namespace ms {
 	/**
 	 * Returns the number of adjacent cells that are the given underlying value (bomb by default).
 	 **/
-	int grid::count_neighbor(int row, int col, cell value) {
+	int grid::count_neighbor(unsigned int index, cell value) const {
 		int count = 0;
-
-		for (int rr = -1; rr <= 1; ++rr) {
-			for (int cc = -1; cc <= 1; ++cc) {
-				if (!(rr == 0 && cc == 0) && iscontained(row + rr, col + cc)) {
-					if (_grid[row + rr][col + cc] == value) {
-						++count;
-					}
-				}
-			}
-		}
-
+		for (int offset : _neighbors)
+			count += under(index + offset) == value;
 		return count;
 	}
 
 	/**
 	 * Returns the number of adjacent cells that are the given visible value (flag by default)
 	 **/
-	int grid::count_vis_neighbor(int row, int col, cell value) {
+	int grid::count_vis_neighbor(unsigned int index, cell value) const {
 		int count = 0;
-
-		for (int rr = -1; rr <= 1; ++rr) {
-			for (int cc = -1; cc <= 1; ++cc) {
-				if (!(rr == 0 && cc == 0) && iscontained(row + rr, col + cc)) {
-					if (_visgrid[row + rr][col + cc] == value) {
-						++count;
-					}
-				}
-			}
-		}
-
+		for (int offset : _neighbors)
+			count += get_at(index + offset) == value;
 		return count;
 	}
 
 	/**
 	 * Initializes the state of the grid such that it has the correct number of bombs 
-	 * and the input location is not a bomb. The input location is opened. If there
+	 * and the input location is not a bomb. The input location is not opened. If there
 	 * are too few spaces to place bombs, init will place as many as it can (it will
 	 * never place on the input location).
+	 * 
+	 * The bombs are placed from the seed (see `set_seed`), which is then replaced by a new seed
+	 * drawn from it, so the next game gets different bombs.
 	 **/
-	std::unordered_set<rc_coord, rc_coord_hash> grid::init(unsigned int row, unsigned int col) {		
+	void grid::init(unsigned int row, unsigned int col) {		
 		std::vector<rc_coord> nonbombs;
+		std::mt19937_64 rng(_seed);
 
-		unopened_cells.clear();
+		visible_hash = 0;
 		for (unsigned int r = 0; r < _height; ++r) {
 			for (unsigned int c = 0; c < _width; ++c) {
-				_visgrid[r][c] = ms_hidden;
-				_grid[r][c] = ms_0;
-				unopened_cells.insert(rc_coord{ r, c });
+				set_vis(index(r, c), ms_hidden);
+				set_under(index(r, c), ms_0);
 				if (!(r == row && c == col)) { //first click is always not a bomb
 					nonbombs.push_back(rc_coord{ r, c });
 				}
@@ -77,39 +83,46 @@ namespace ms {
 
 		for (unsigned int b = 0; b < _bombs && !nonbombs.empty(); ++b) {
 			int index = rng() % nonbombs.size();
-			_grid[nonbombs[index].row][nonbombs[index].col] = ms_bomb;
+			set_under(this->index(nonbombs[index].row, nonbombs[index].col), ms_bomb);
 			std::swap(nonbombs[index], nonbombs.back());
 			nonbombs.pop_back();
 		}
+		_seed = rng();
+		reset_unopened__();
 
 		for (unsigned int r = 0; r < _height; ++r) {
 			for (unsigned int c = 0; c < _width; ++c) {
-				if (_grid[r][c] != ms_bomb)
-					_grid[r][c] = (cell) count_neighbor(r, c, ms_bomb);
+				if (under(index(r, c)) != ms_bomb)
+					set_under(index(r, c), (cell) count_neighbor(index(r, c), ms_bomb));
 			}
 		}
 
 		_gs = RUNNING;
-
-		return open(row, col);
 	}
 
 
 	/**
 	 * initializes the grid with the correct height, width, and bombs. Allocates
-	 * space for the hidden and visible data (2 * height * width bytes of data). 
+	 * space for the hidden and visible data ((height + 2) * (width + 2) bytes of data, and a bit
+	 * per cell for the unopened cells), with every cell `ms_0` underneath and `ms_hidden` on top,
+	 * and the border `ms_error`. No cell is marked unopened until the game starts.
 	 **/
 	int grid::allocate__(unsigned int height, unsigned int width, unsigned int bombs) {
 		_width = width > 0 ? width : 1;
 		_height = height > 0 ? height : 1;
 		_bombs = bombs;
-		_grid = new cell*[_height];
-		_visgrid = new cell*[_height];
+		_seed = random_seed();
+		_stride = _width + 2;
+		_size = (_height + 2) * _stride;
+		int stride = _stride;
+		_neighbors = { -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1 };
+		_cells.assign(_size, 0xff);
 		for (unsigned int h = 0; h < _height; ++h) {
-			_grid[h] = new cell[_width]();
-			_visgrid[h] = new cell[_width];
-			std::fill_n(_visgrid[h],_width,ms_hidden);
+			std::fill_n(_cells.begin() + index(h, 0), _width, ms_0 | ms_hidden << 4);
 		}
+		_unopened.assign((_size + 63) / 64, 0);
+		unopened_count = 0;
+		hidden_safe = 0;
 
 		return 0;
 	}
@@ -121,18 +134,18 @@ namespace ms {
 
 		for(unsigned int r = 0; r < _height; ++r) {
 			for(unsigned int c = 0; c < _width; ++c) {
-				unopened_cells.insert(rc_coord(r,c));
 				if(arr[r][c] == ms_bomb) {
-					_grid[r][c] = ms_bomb;
+					set_under(index(r, c), ms_bomb);
 					++_bombs;
 				}
 			}
 		}
+		reset_unopened__();
 
 		for (unsigned int r = 0; r < _height; ++r) {
 			for (unsigned int c = 0; c < _width; ++c) {
-				if (_grid[r][c] != ms_bomb)
-					_grid[r][c] = (cell) count_neighbor(r, c, ms_bomb);
+				if (under(index(r, c)) != ms_bomb)
+					set_under(index(r, c), (cell) count_neighbor(index(r, c), ms_bomb));
 			}
 		}
 	}
@@ -143,60 +156,70 @@ namespace ms {
 		flag_count = 0;
 	}
 
-	grid::grid(const grid& copy, copy_type gct) {
-
-		allocate__(copy._height,copy._width,copy._bombs);
+	/**
+	 * Copies a grid. The underlying and visible values are stored in one buffer, so full copies
+	 * are a single copy of it.
+	 **/
+	grid::grid(const grid& copy, copy_type gct) :
+		_height(copy._height), _width(copy._width), _bombs(copy._bombs), _stride(copy._stride),
+		_size(copy._size), _neighbors(copy._neighbors), _seed(copy._seed) {
 
 		switch(gct) {
 		case FULL_COPY:
-			for(unsigned int r = 0; r < _height; ++r) {
-				for(unsigned int c = 0; c < _width; ++c) {
-					_visgrid[r][c] = copy._visgrid[r][c];
-					_grid[r][c] = copy._grid[r][c];
-				}
-			}
-			unopened_cells = copy.unopened_cells;
+			_cells = copy._cells;
+			_unopened = copy._unopened;
+			unopened_count = copy.unopened_count;
+			hidden_safe = copy.hidden_safe;
 			_gs = copy._gs;
 			flag_count = copy.flag_count;
+			visible_hash = copy.visible_hash;
 			break;
 		case HIDDEN_COPY:
-			unopened_cells.clear();
+			_cells = copy._cells;
 			for(unsigned int r = 0; r < _height; ++r) {
 				for(unsigned int c = 0; c < _width; ++c) {
-					_visgrid[r][c] = ms_hidden;
-					_grid[r][c] = copy._grid[r][c];
-					unopened_cells.insert(rc_coord(r,c));
+					set_vis(index(r, c), ms_hidden);
 				}
 			}
+			reset_unopened__();
 			_gs = RUNNING;
 			flag_count = 0;
 			break;
 		case SURFACE_COPY:
-			for(unsigned int r = 0; r < _height; ++r) {
-				for(unsigned int c = 0; c < _width; ++c) {
-					_visgrid[r][c] = copy._visgrid[r][c];
-					_grid[r][c] = grid::ms_error;
-				}
-			}	
-			unopened_cells = copy.unopened_cells;
-			_gs = copy._gs;	
-			flag_count = copy.flag_count;
+			copy_surface(copy);
 			break;
 		case PARAM_COPY:
+			allocate__(copy._height,copy._width,copy._bombs);
 			_gs = NEW;
+			flag_count = 0;
 			break;
 		}
 	}
 
-
-	grid::~grid() {
-		for (unsigned int h = 0; h < _height; ++h) {
-			delete[] _grid[h];
-			delete[] _visgrid[h];
-		}
-
-		delete[] _grid;
-		delete[] _visgrid;
+	/**
+	 * Makes the grid a `SURFACE_COPY` of `copy`, dropping any checkpoints. The storage of the grid
+	 * is reused, so refreshing a copy of a grid of the same size does not allocate.
+	 **/
+	void grid::copy_surface(const grid& copy) {
+		_height = copy._height;
+		_width = copy._width;
+		_bombs = copy._bombs;
+		_stride = copy._stride;
+		_size = copy._size;
+		_neighbors = copy._neighbors;
+		_seed = copy._seed;
+		_cells = copy._cells;
+		for(std::uint8_t& packed : _cells)
+			packed |= 0x0f;
+		_unopened = copy._unopened;
+		unopened_count = copy.unopened_count;
+		//no underlying cell is a bomb, so the game is only won once every cell is opened
+		hidden_safe = unopened_count;
+		_gs = copy._gs;
+		flag_count = copy.flag_count;
+		visible_hash = copy.visible_hash;
+		trail.clear();
+		checkpoints.clear();
 	}
 
 	/**
@@ -208,17 +231,17 @@ namespace ms {
 		if (_gs != RUNNING || !iscontained(row, col))
 			return 1;
 
-		switch (_visgrid[row][col]) {
+		switch (get_at(index(row, col))) {
 		case ms_hidden:
 			++flag_count;
-			_visgrid[row][col] = ms_flag;
+			set_visible__(row, col, ms_flag);
 			return 0;
 		case ms_flag:
 			--flag_count;
-			_visgrid[row][col] = ms_question;
+			set_visible__(row, col, ms_question);
 			return 0;
 		case ms_question:
-			_visgrid[row][col] = ms_hidden;
+			set_visible__(row, col, ms_hidden);
 			return 0;
 		default:
 			return 1;
@@ -237,110 +260,136 @@ namespace ms {
 				(flag != ms_flag && flag != ms_hidden && flag != ms_question))
 			return 1;
 		
-		switch (_visgrid[row][col]) {
+		switch (get_at(index(row, col))) {
 		case ms_hidden:
 		case ms_question:
 			if(flag == ms_flag)
 				++flag_count;//increment flag if becoming a flag
-			_visgrid[row][col] = flag;
+			set_visible__(row, col, flag);
 			return 0;
 		case ms_flag:
 			if(flag != ms_flag)
 				--flag_count;
-			_visgrid[row][col] = flag;
+			set_visible__(row, col, flag);
 			return 0;
 		default:
 			return 1;
 		}
 	}
 
-	std::unordered_set<rc_coord, rc_coord_hash> grid::open__(int row, int col) {
-		std::unordered_set<rc_coord, rc_coord_hash> all_opened = {};
-		std::unordered_set<rc_coord, rc_coord_hash> to_open = { rc_coord(row,col) };
-		std::unordered_set<rc_coord, rc_coord_hash> next_open = {};
-
-		while(!to_open.empty()) {
-			for(rc_coord opening  : to_open) {
-				cell vis = _visgrid[opening.row][opening.col];
-
-				if(count_vis_neighbor(opening.row, opening.col) == vis) { // implies 0 <= vis <= 8
-					for(int rr = -1; rr <= 1; ++rr) {
-						for(int cc = -1; cc <= 1; ++cc) {
-							if (!(rr == 0 && cc == 0) && iscontained(opening.row + rr, opening.col + cc))
-								if(_visgrid[opening.row + rr][opening.col + cc] == ms_hidden || _visgrid[opening.row + rr][opening.col + cc] == ms_question)
-									next_open.insert(rc_coord(opening.row + rr, opening.col + cc));
-						}
-					}
-				} else if (vis == ms_hidden || vis == ms_question) {
-					_visgrid[opening.row][opening.col] = _grid[opening.row][opening.col];
-					if(_visgrid[opening.row][opening.col] == ms_0)
-						next_open.insert(opening);
-					else if(_visgrid[opening.row][opening.col] == ms_bomb)
-						_gs = LOST;
-					all_opened.insert(opening);
-					unopened_cells.erase(unopened_cells.find(opening));
-				} else if (vis != ms_flag && (vis > ms_8 || vis < ms_0)) {
-					throw grid_error("Could not open cell " + rc_coord(row,col).to_string());
-				}
+	/**
+	 * Opens the cell at a linear index, and appends the cells opened to `opened`.
+	 * 
+	 * A hidden cell is opened, and the hidden neighbors of every cell opened showing 0 are opened
+	 * in turn, breadth first from a queue. A number with as many flags around it as it shows has
+	 * its hidden neighbors opened (and expanded the same way). Cells are marked in a bitmap when
+	 * queued, so each is queued once.
+	 * 
+	 * Complexity \f$O(M)\f$ where \f$M\f$ is the number of cells opened
+	 **/
+	void grid::open__(unsigned int start, std::vector<rc_coord>& opened) {
+		if(flood_queued.size() != _unopened.size())
+			flood_queued.assign(_unopened.size(), 0);
+		flood_queue.clear();
+
+		auto enqueue = [this](unsigned int at) {
+			cell value = get_at(at);
+			std::uint64_t bit = std::uint64_t(1) << (at & 63);
+			if((value == ms_hidden || value == ms_question) && !(flood_queued[at >> 6] & bit)) {
+				flood_queued[at >> 6] |= bit;
+				flood_queue.push_back(at);
+			}
+		};
+
+		cell visible = get_at(start);
+		if(visible == ms_hidden || visible == ms_question) {
+			enqueue(start);
+		} else if(visible >= ms_0 && visible <= ms_8) {
+			if(count_vis_neighbor(start) == visible) {
+				for(int offset : _neighbors)
+					enqueue(start + offset);
 			}
-			to_open = std::move(next_open);
-			next_open.clear();
+		} else if(visible != ms_flag) {
+			throw grid_error("Could not open cell " + coord(start).to_string());
 		}
-		return all_opened;
+
+		for(size_t head = 0; head < flood_queue.size(); ++head) {
+			unsigned int at = flood_queue[head];
+			rc_coord opening = coord(at);
+			cell value = under(at);
+			set_visible__(opening.row, opening.col, value);
+			mark_opened__(opening);
+			opened.push_back(opening);
+			if(value == ms_bomb) {
+				_gs = LOST;
+			} else if(value == ms_0) {
+				for(int offset : _neighbors)
+					enqueue(at + offset);
+			}
+		}
+
+		for(unsigned int at : flood_queue)
+			flood_queued[at >> 6] = 0;
 	}
 
 
 	/**
-	 * Returns an unordered set of cells opened
+	 * Returns the cells opened, in the order they were opened.
+	 * 
+	 * throws an error if the cell could not be opened
+	 **/
+	std::vector<rc_coord> grid::open(unsigned int row, unsigned int col) {
+		std::vector<rc_coord> ret;
+		open(row, col, ret);
+		return ret;
+	}
+
+	/**
+	 * Opens a cell like `open(row, col)`, but writes the cells opened into `opened` (which is
+	 * cleared first) so a buffer can be reused between calls without allocating.
 	 * 
 	 * throws an error if the cell could not be opened
 	 **/
-	std::unordered_set<rc_coord, rc_coord_hash> grid::open(unsigned int row, unsigned int col) {
-		std::unordered_set<rc_coord, rc_coord_hash> ret;
+	void grid::open(unsigned int row, unsigned int col, std::vector<rc_coord>& opened) {
+		opened.clear();
 		if(_gs == WON || _gs == LOST)
-			return ret;
+			return;
 		if (!iscontained(row, col))
 			throw grid_error("attempted to open cell " + rc_coord(row, col).to_string() + "not contained in grid");
 		else if (_gs == NEW) {
-			ret = init(row, col);
-		} else
-			ret = open__((signed int)row, (signed int)col);
+			if(!checkpoints.empty())
+				throw grid_error("attempted to start a game while a checkpoint is active");
+			init(row, col);
+		}
+		open__(index(row, col), opened);
 
 		update_if_won();
 		if(_gs == WON) {
 			_gs = RUNNING;//temporarily allow set_flag
-			for(rc_coord cell : unopened_cells) {
-				if(_grid[cell.row][cell.col] == ms_bomb)
-					set_flag(cell.row,cell.col,ms_flag);
+			for(unsigned int at = next_unopened(0); at < index_end(); at = next_unopened(at + 1)) {
+				if(under(at) == ms_bomb)
+					set_flag(coord(at).row, coord(at).col, ms_flag);
 			}
 			_gs = WON;
 		} else if (_gs == LOST) {
-			for(rc_coord cell : unopened_cells) {
-				if(_grid[cell.row][cell.col] == ms_bomb && _visgrid[cell.row][cell.col] != ms_flag)
-					_visgrid[cell.row][cell.col] = ms_unopened_bomb;
+			for(unsigned int at = next_unopened(0); at < index_end(); at = next_unopened(at + 1)) {
+				if(under(at) == ms_bomb && get_at(at) != ms_flag)
+					set_visible__(coord(at).row, coord(at).col, ms_unopened_bomb);
 			}			
 		}
-
-		return ret;
 	}
 
 	/**
 	 * Checks if the game has been won (only bombs hidden, no bombs open).
 	 *   - returns 1 if the gamestate is updated to WON 
 	 *   - returns 0 otherwise
+	 * 
+	 * Complexity \f$O(1)\f$
 	 **/
 	int grid::update_if_won() {
 		if (_gs != RUNNING)
 			return 0;
-		bool only_bombs_unopened = true;
-		for(rc_coord cell : unopened_cells) {
-			if(_grid[cell.row][cell.col] != ms_bomb) {
-				assert(_visgrid[cell.row][cell.col] != _grid[cell.row][cell.col]);
-				only_bombs_unopened = false;
-				break;
-			}
-		}
-		if (only_bombs_unopened) {
+		if (hidden_safe == 0) {
 			_gs = WON;
 			return 1;
 		}
@@ -353,23 +402,163 @@ namespace ms {
 	 * (bombs are not placed until first cell opened)
 	 **/
 	void grid::reset() {
+		checkpoints.clear();
+		trail.clear();
 		_gs = NEW;
 		for (unsigned int r = 0; r < _height; ++r) {
 			for (unsigned int c = 0; c < _width; ++c) {
-				_visgrid[r][c] = ms_hidden;
+				set_vis(index(r, c), ms_hidden);
 			}
 		}
 		flag_count = 0;
+		visible_hash = 0;
 	}
 
 	/**
 	 * resets all flags to ms_hidden
 	 **/
 	void grid::clear_all_flags() {
-		for(rc_coord cell : unopened_cells) {
-			_visgrid[cell.row][cell.col] = ms_hidden;
+		for(unsigned int at = next_unopened(0); at < index_end(); at = next_unopened(at + 1)) {
+			set_visible__(coord(at).row, coord(at).col, ms_hidden);
 		}
 		flag_count = 0;
 	}
 
+	/**
+	 * Shows `value` in a hidden cell without opening it, as if the cell had been opened and
+	 * found to be `value`. The hidden contents of the grid are not used or changed, so this can
+	 * be used to analyse a hypothetical move, and must be undone with `rollback`.
+	 * 
+	 * Returns 0 on success, 1 if the cell is not hidden. Throws grid_error if no checkpoint is active.
+	 **/
+	int grid::assume(unsigned int row, unsigned int col, cell value) {
+		if(checkpoints.empty())
+			throw grid_error("attempted to assume the value of a cell without a checkpoint");
+		if(!iscontained(row, col) || (get_at(index(row, col)) != ms_hidden && get_at(index(row, col)) != ms_question))
+			return 1;
+		set_visible__(row, col, value);
+		mark_opened__(rc_coord(row, col));
+		return 0;
+	}
+
+	/**
+	 * Starts recording the changes to the visible grid (including the gamestate and flags) so
+	 * they can be undone by `rollback`. Checkpoints nest: each `rollback` undoes the changes
+	 * since the most recent checkpoint.
+	 * 
+	 * Only the visible grid is recorded, so a game can not be started while a checkpoint is active.
+	 * 
+	 * Complexity \f$O(1)\f$
+	 **/
+	void grid::checkpoint() {
+		checkpoints.push_back(checkpoint_state{ trail.size(), _gs, flag_count });
+	}
+
+	/**
+	 * Undoes every change to the visible grid since the most recent checkpoint, and removes the checkpoint.
+	 * 
+	 * Complexity \f$O(M)\f$ where \f$M\f$ is the number of changes since the checkpoint
+	 **/
+	void grid::rollback() {
+		assert(!checkpoints.empty());
+		const checkpoint_state& state = checkpoints.back();
+		while(trail.size() > state.trail_size) {
+			const trail_entry& entry = trail.back();
+			if(entry.opened) {
+				mark_unopened__(index(entry.location.row, entry.location.col));
+			} else {
+				unsigned int at = index(entry.location.row, entry.location.col);
+				visible_hash ^= zobrist_key(entry.location.row, entry.location.col, get_at(at))
+					^ zobrist_key(entry.location.row, entry.location.col, entry.visible);
+				set_vis(at, entry.visible);
+			}
+			trail.pop_back();
+		}
+		_gs = state.gs;
+		flag_count = state.flag_count;
+		checkpoints.pop_back();
+	}
+
+	/**
+	 * Sets the visible value of a cell, recording the old value if a checkpoint is active.
+	 **/
+	void grid::set_visible__(unsigned int row, unsigned int col, cell value) {
+		unsigned int at = index(row, col);
+		if(!checkpoints.empty())
+			trail.push_back(trail_entry{ rc_coord(row, col), get_at(at), false });
+		visible_hash ^= zobrist_key(row, col, get_at(at)) ^ zobrist_key(row, col, value);
+		set_vis(at, value);
+	}
+
+	/**
+	 * Returns the Zobrist key of a cell showing `value`. Keys are a fixed pseudo random function
+	 * of the cell and value (the splitmix64 finalizer), so they are the same for every grid.
+	 **/
+	std::uint64_t grid::zobrist_key(unsigned int row, unsigned int col, cell value) {
+		if(value == ms_hidden)
+			return 0;
+		return mix(std::uint64_t(row) << 40 | std::uint64_t(col) << 8 | std::uint8_t(value));
+	}
+
+	/**
+	 * Removes a cell from the unopened cells, recording it if a checkpoint is active.
+	 **/
+	void grid::mark_opened__(rc_coord cell) {
+		if(!checkpoints.empty())
+			trail.push_back(trail_entry{ cell, ms_error, true });
+		unsigned int at = index(cell.row, cell.col);
+		assert(is_unopened(at));
+		_unopened[at >> 6] &= ~(std::uint64_t(1) << (at & 63));
+		--unopened_count;
+		if(under(at) != ms_bomb)
+			--hidden_safe;
+	}
+
+	/**
+	 * Adds a cell back to the unopened cells, without recording it.
+	 **/
+	void grid::mark_unopened__(unsigned int index) {
+		assert(!is_unopened(index));
+		_unopened[index >> 6] |= std::uint64_t(1) << (index & 63);
+		++unopened_count;
+		if(under(index) != ms_bomb)
+			++hidden_safe;
+	}
+
+	/**
+	 * Marks every cell of the grid unopened. The underlying values must already be set.
+	 **/
+	void grid::reset_unopened__() {
+		std::fill(_unopened.begin(), _unopened.end(), 0);
+		hidden_safe = 0;
+		for (unsigned int r = 0; r < _height; ++r) {
+			for (unsigned int c = 0; c < _width; ++c) {
+				_unopened[index(r, c) >> 6] |= std::uint64_t(1) << (index(r, c) & 63);
+				hidden_safe += under(index(r, c)) != ms_bomb;
+			}
+		}
+		unopened_count = _height * _width;
+	}
+
+	/**
+	 * Returns the linear index (see `index`) of the first unopened cell at or after `index`, or
+	 * `index_end()` if there is none. Flagged cells are unopened. Every unopened cell is visited by
+	 * 
+	 *     for(unsigned i = g.next_unopened(0); i < g.index_end(); i = g.next_unopened(i + 1))
+	 * 
+	 * Complexity \f$O(N / 64)\f$ in the worst case, skipping 64 cells at a time
+	 **/
+	unsigned int grid::next_unopened(unsigned int index) const {
+		unsigned int word = index >> 6;
+		if(word >= _unopened.size())
+			return _size;
+		std::uint64_t bits = _unopened[word] & (~std::uint64_t(0) << (index & 63));
+		while(bits == 0) {
+			if(++word == _unopened.size())
+				return _size;
+			bits = _unopened[word];
+		}
+		return word * 64 + __builtin_ctzll(bits);
+	}
+
 }
\ No newline at end of file
@@ -1,9 +1,10 @@
 #ifndef MS_GRID_H
 #define MS_GRID_H
 
-#include <random>
+#include <array>
+#include <cstdint>
 #include <stdexcept>
-#include <unordered_set>
+#include <vector>
 #include "rc_coord.h"
 
 namespace ms {
@@ -88,52 +89,139 @@ namespace ms {
 
 
 	private:
-		std::unordered_set<rc_coord, rc_coord_hash> init(unsigned int row, unsigned int col);
+		/**A change to the visible grid, recorded while a checkpoint is active so it can be undone**/
+		struct trail_entry {
+			rc_coord location;
+			/**the visible value before the change**/
+			cell visible;
+			/**true if the cell was removed from `_unopened` instead of changing the visible value**/
+			bool opened;
+		};
+		/**The state restored by `rollback` that is not kept in the trail**/
+		struct checkpoint_state {
+			size_t trail_size;
+			enum gamestate gs;
+			unsigned flag_count;
+		};
+
+		void init(unsigned int row, unsigned int col);
 		int update_if_won();
-		std::unordered_set<rc_coord, rc_coord_hash> open__(int row, int col);
+		void open__(unsigned int start, std::vector<rc_coord>& opened);
 		int allocate__(unsigned int row, unsigned int col, unsigned int bombs);
-		int count_neighbor(int row, int col, cell value = ms_bomb);
-		int count_vis_neighbor(int row, int col, cell value = ms_flag);
-		/**Checks the contents of `_grid` with bounds checking**/
+		int count_neighbor(unsigned int index, cell value = ms_bomb) const;
+		int count_vis_neighbor(unsigned int index, cell value = ms_flag) const;
+		/**Returns the cell stored in a nibble of `_cells`, where `ms_error` is stored as `0xf`**/
+		static cell decode(std::uint8_t nibble) { return nibble == 0xf ? ms_error : cell(nibble); }
+		/**Returns the underlying value of the cell at a linear index, see `index`**/
+		cell under(unsigned int index) const { return decode(_cells[index] & 0xf); }
+		void set_under(unsigned int index, cell value) { _cells[index] = (_cells[index] & 0xf0) | (value & 0xf); }
+		/**Sets the visible value of the cell at a linear index without recording it, see `set_visible__`**/
+		void set_vis(unsigned int index, cell value) { _cells[index] = (_cells[index] & 0x0f) | (value & 0xf) << 4; }
+		/**Checks the underlying contents of the grid with bounds checking**/
 		cell peek(unsigned int row, unsigned int col) const {
-			if (iscontained(row, col)) return _grid[row][col]; else return ms_error; 
+			if (iscontained(row, col)) return under(index(row, col)); else return ms_error; 
 		}
 		unsigned int _height, _width, _bombs;
-		cell ** _grid;
-		cell ** _visgrid;
+		/**the length of a row of `_cells`, including the border on each side**/
+		unsigned int _stride;
+		/**the number of cells of `_cells`, including the border**/
+		unsigned int _size;
+		/**differences between the linear index of a cell and those of its 8 neighbors**/
+		std::array<int, 8> _neighbors;
+		/**the seed the bombs of the next game are placed from**/
+		std::uint64_t _seed;
+		/**
+		 * One byte per cell, stored row by row with a border one cell wide around the grid so
+		 * neighbors of any cell can be read without bounds checking. The low nibble holds the
+		 * underlying value and the high nibble the visible value, both `ms_error` on the border.
+		 **/
+		std::vector<std::uint8_t> _cells;
 		gamestate _gs;
-		std::unordered_set<rc_coord, rc_coord_hash> unopened_cells;
+		/**one bit per linear index, set for the cells that are not opened (including flags)**/
+		std::vector<std::uint64_t> _unopened;
+		/**the number of bits set in `_unopened`**/
+		unsigned unopened_count;
+		/**the number of unopened cells that are not bombs underneath, the game is won when it reaches 0**/
+		unsigned hidden_safe;
+		//scratch space for `open__`, not copied with the grid
+		std::vector<unsigned int> flood_queue;
+		/**one bit per linear index, set for the cells in `flood_queue`**/
+		std::vector<std::uint64_t> flood_queued;
 		unsigned flag_count;
-		static std::mt19937 rng;
+		/**Zobrist hash of the visible grid, hidden cells are not included**/
+		std::uint64_t visible_hash = 0;
+		std::vector<trail_entry> trail;
+		std::vector<checkpoint_state> checkpoints;
+
+		static std::uint64_t zobrist_key(unsigned int row, unsigned int col, cell value);
+		void set_visible__(unsigned int row, unsigned int col, cell value);
+		void mark_opened__(rc_coord cell);
+		void mark_unopened__(unsigned int index);
+		void reset_unopened__();
 	public:
 		grid(unsigned int height, unsigned int width, unsigned int bombs);
 		grid(unsigned int height, unsigned int width, cell ** arr);
 		grid(const grid& copy, copy_type gct);
+		void copy_surface(const grid& copy);
 
 		unsigned int width() const { return _width; }
 		unsigned int height() const { return _height; }
 		unsigned int bombs() const { return _bombs; }
 		gamestate gamestate() const { return _gs; }
 		bool iscontained(int row, int col) const;
-		int count_unopened() const { return unopened_cells.size() - flag_count; }
+		int count_unopened() const { return unopened_count - flag_count; }
 		int count_flags() const { return flag_count; }
 		int remaining_bombs() const { return bombs() - flag_count > 0 ? bombs() - flag_count : 0; }
+		/**
+		 * Returns a Zobrist hash of the visible grid, so grids showing the same cells have the same hash.
+		 * The hash of a grid where every cell is hidden is 0.\n Complexity \f$O(1)\f$
+		 **/
+		std::uint64_t hash() const { return visible_hash; }
+
+		/**
+		 * Sets the seed the bombs of the next game are placed from. Games started with the same seed
+		 * and the same first move have the same bombs. Grids start with a `random_seed`.\n Complexity \f$O(1)\f$
+		 **/
+		void set_seed(std::uint64_t seed) { _seed = seed; }
+		/**Returns the seed the bombs of the next game will be placed from.\n Complexity \f$O(1)\f$**/
+		std::uint64_t seed() const { return _seed; }
+		static std::uint64_t random_seed();
 
 		/**Returns the visible contents of a cell. Return `ms_error` if the specified cell is not contained in the grid.**/
 		cell get(unsigned int row, unsigned int col) const { 
-			if (iscontained(row, col)) return _visgrid[row][col]; else return ms_error; 
+			if (iscontained(row, col)) return get_at(index(row, col)); else return ms_error; 
 		}
+
+		/**
+		 * Returns the linear index of a contained cell. The neighbors of the cell are at the index
+		 * plus each of `neighbor_offsets`, and the indices around the grid show `ms_error`.\n Complexity \f$O(1)\f$
+		 **/
+		unsigned int index(unsigned int row, unsigned int col) const { return (row + 1) * _stride + col + 1; }
+		/**Returns the cell at a linear index that is not on the border, see `index`.\n Complexity \f$O(1)\f$**/
+		rc_coord coord(unsigned int index) const { return rc_coord(index / _stride - 1, index % _stride - 1); }
+		/**Returns the visible contents of the cell at a linear index (see `index`), `ms_error` on the border.\n Complexity \f$O(1)\f$**/
+		cell get_at(unsigned int index) const { return decode(_cells[index] >> 4); }
+		/**Returns the differences between the linear index of a cell and those of its 8 neighbors.\n Complexity \f$O(1)\f$**/
+		const std::array<int, 8>& neighbor_offsets() const { return _neighbors; }
+		/**Returns one past the largest linear index, see `index`.\n Complexity \f$O(1)\f$**/
+		unsigned int index_end() const { return _size; }
+		/**Returns true if the cell at a linear index is not opened (it may be flagged), see `index`.\n Complexity \f$O(1)\f$**/
+		bool is_unopened(unsigned int index) const { return _unopened[index >> 6] >> (index & 63) & 1; }
+		unsigned int next_unopened(unsigned int index) const;
 		
 		int flag(unsigned int row, unsigned int col);
 		int set_flag(unsigned int row, unsigned int col, cell flag);
 		void clear_all_flags();
-		std::unordered_set<rc_coord, rc_coord_hash> open(unsigned int row, unsigned int col);
+		std::vector<rc_coord> open(unsigned int row, unsigned int col);
+		void open(unsigned int row, unsigned int col, std::vector<rc_coord>& opened);
+		int assume(unsigned int row, unsigned int col, cell value);
 		
 		void reset();
 
-		~grid();
-
-
+		void checkpoint();
+		void rollback();
+		/**Returns the number of checkpoints that have not been rolled back.**/
+		size_t checkpoint_depth() const { return checkpoints.size(); }
 
 
 	};
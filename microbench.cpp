@@ -0,0 +1,330 @@
+#include "grid.h"
+#include "region.h"
+#include "region_set.h"
+#include "solver.h"
+#include "game_runner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Times the operations on regions and region sets that the solver spends its time in, and the
+ * copy of a solver and the refresh of the snapshot each worker of `solver::expected_payouts` uses,
+ * on regions recorded from real games.
+ *
+ * usage: microbench [height width bombs [games [seed]]]
+ *
+ * `games` games (50 by default) are played with seeds from `seed` (fixed by default, so runs can be
+ * compared), and the regions of the solver are recorded before every guess, when the region sets
+ * are largest. Each operation is then repeated over the recorded regions for at least
+ * `MIN_TIME`, and reported in nanoseconds, heap allocations and bytes allocated per operation.
+ **/
+
+namespace {
+
+    std::atomic<std::uint64_t> allocations{ 0 };
+    std::atomic<std::uint64_t> allocated_bytes{ 0 };
+
+}
+
+//counts every allocation, gcc mistakes the malloc and free below for a mismatched pair once they are inlined
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if(void* ret = std::malloc(size ? size : 1))
+        return ret;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+    /**least time spent repeating each operation**/
+    constexpr std::chrono::milliseconds MIN_TIME{ 300 };
+    /**most pairs of regions kept for the operations on two regions**/
+    constexpr size_t MAX_PAIRS = 200000;
+    /**regions after each region of a set that it is tested against with `has_intersect`**/
+    constexpr size_t NEIGHBORHOOD = 8;
+    /**most safe cells removed from each recorded set by `remove_safe`**/
+    constexpr size_t SAFE_CELLS = 8;
+
+    /**gives access to the regions of a solver and to refreshing the snapshots of its workers**/
+    class recording_solver : public ms::solver {
+    public:
+        using ms::solver::solver;
+        const ms::region_set& get_regions() const { return regions; }
+        void refresh(ms::solver& snapshot) const { refresh_snapshot(snapshot); }
+    };
+
+    /**the state of a game before a guess**/
+    struct snapshot {
+        std::vector<ms::region> regions;
+        ms::region_set set;
+        /**hidden cells in the regions that are not bombs**/
+        std::vector<ms::rc_coord> safe;
+        std::unique_ptr<recording_solver> ai;
+    };
+
+    /**the time and allocations of the repetitions of one operation**/
+    class measurement {
+    public:
+        void start() {
+            start_allocs = allocations.load(std::memory_order_relaxed);
+            start_bytes = allocated_bytes.load(std::memory_order_relaxed);
+            start_time = std::chrono::steady_clock::now();
+        }
+        void stop(size_t ops) {
+            elapsed += std::chrono::steady_clock::now() - start_time;
+            allocs += allocations.load(std::memory_order_relaxed) - start_allocs;
+            bytes += allocated_bytes.load(std::memory_order_relaxed) - start_bytes;
+            this->ops += ops;
+        }
+        bool done() const { return elapsed >= MIN_TIME; }
+        void print(const char* name) const {
+            double n = ops ? ops : 1;
+            printf("%-34s %10.1f %11.2f %11.1f  (%llu ops)\n", name,
+                std::chrono::duration<double, std::nano>(elapsed).count() / n, allocs / n, bytes / n,
+                (unsigned long long) ops);
+        }
+    private:
+        std::chrono::steady_clock::duration elapsed{ 0 };
+        std::chrono::steady_clock::time_point start_time;
+        std::uint64_t start_allocs = 0, start_bytes = 0;
+        std::uint64_t allocs = 0, bytes = 0, ops = 0;
+    };
+
+    /**keeps results from being optimized away**/
+    volatile size_t sink;
+
+    /**Returns the hidden cells of the regions of `ai` that are not bombs, at most `SAFE_CELLS` of them.**/
+    std::vector<ms::rc_coord> find_safe(const recording_solver& ai, const ms::region_set& set) {
+        std::vector<ms::rc_coord> ret;
+        ms::grid full = ai.get_grid();
+        for(const ms::region& reg : set) {
+            for(ms::rc_coord cell : reg) {
+                if(ret.size() >= SAFE_CELLS)
+                    return ret;
+                if(std::find(ret.begin(), ret.end(), cell) != ret.end())
+                    continue;
+                ms::grid trial(full, ms::grid::FULL_COPY);
+                trial.open(cell.row, cell.col);
+                if(trial.gamestate() != ms::grid::LOST)
+                    ret.push_back(cell);
+            }
+        }
+        return ret;
+    }
+
+    /**Plays seeded games and records the regions before every guess.**/
+    std::vector<snapshot> record(unsigned height, unsigned width, unsigned bombs, unsigned games, std::uint64_t seed) {
+        std::vector<snapshot> ret;
+        for(unsigned game = 0; game < games; ++game) {
+            recording_solver ai(height, width, bombs);
+            ai.set_seed(ms::game_runner::game_seed(seed, game));
+            ai.step();
+            while(ai.gamestate() == ms::grid::RUNNING) {
+                if(ai.step_certain() != ms::BAD_RC_COORD)
+                    continue;
+                if(ai.gamestate() != ms::grid::RUNNING)
+                    break;
+                const ms::region_set& set = ai.get_regions();
+                if(!set.empty()) {
+                    snapshot snap{ std::vector<ms::region>(set.begin(), set.end()), set, find_safe(ai, set),
+                        std::unique_ptr<recording_solver>(new recording_solver(ai, ms::grid::FULL_COPY)) };
+                    ret.push_back(std::move(snap));
+                }
+                if(ai.step() == ms::BAD_RC_COORD)
+                    break;
+            }
+        }
+        return ret;
+    }
+
+}
+
+int main(int argc, char ** argv) {
+    int height = 16, width = 16, bombs = 40, games = 50;
+    std::uint64_t seed = 1;
+    if(argc > 3) {
+        try {
+            height = std::stoi(argv[1]);
+            width  = std::stoi(argv[2]);
+            bombs  = std::stoi(argv[3]);
+            if(argc > 4)
+                games = std::stoi(argv[4]);
+            if(argc > 5)
+                seed = std::stoull(argv[5]);
+        } catch (std::exception&) {
+            fprintf(stderr, "usage: %s [height width bombs [games [seed]]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<snapshot> snapshots = record(height, width, bombs, games, seed);
+    if(snapshots.empty()) {
+        printf("no regions recorded\n");
+        return 0;
+    }
+
+    std::vector<std::pair<const ms::region*, const ms::region*>> overlapping, nearby;
+    size_t total_regions = 0, total_cells = 0, total_safe = 0;
+    for(const snapshot& snap : snapshots) {
+        total_regions += snap.regions.size();
+        total_safe += snap.safe.size();
+        for(size_t i = 0; i < snap.regions.size(); ++i) {
+            total_cells += snap.regions[i].size();
+            for(size_t j = i + 1; j < snap.regions.size() && j <= i + NEIGHBORHOOD; ++j) {
+                if(nearby.size() < MAX_PAIRS)
+                    nearby.emplace_back(&snap.regions[i], &snap.regions[j]);
+            }
+            for(size_t j = 0; j < snap.regions.size(); ++j) {
+                if(i != j && overlapping.size() < MAX_PAIRS && snap.regions[i].has_intersect(snap.regions[j]))
+                    overlapping.emplace_back(&snap.regions[i], &snap.regions[j]);
+            }
+        }
+    }
+    printf("%dx%d with %d bombs, %d games from seed %llu: %zu region sets of %.1f regions of %.2f cells\n",
+        height, width, bombs, games, (unsigned long long) seed, snapshots.size(),
+        double(total_regions) / snapshots.size(), double(total_cells) / total_regions);
+    printf("%-34s %10s %11s %11s\n", "operation", "ns/op", "allocs/op", "bytes/op");
+
+    {
+        measurement m;
+        while(!m.done()) {
+            m.start();
+            for(const auto& pair : overlapping)
+                sink = pair.first->intersect(*pair.second).size();
+            m.stop(overlapping.size());
+        }
+        m.print("region::intersect");
+    }
+    {
+        measurement m;
+        while(!m.done()) {
+            m.start();
+            for(const auto& pair : overlapping)
+                sink = pair.first->subtract(*pair.second).size();
+            m.stop(overlapping.size());
+        }
+        m.print("region::subtract");
+    }
+    {
+        measurement m;
+        while(!m.done()) {
+            m.start();
+            for(const auto& pair : overlapping)
+                sink = pair.first->samearea(*pair.second);
+            m.stop(overlapping.size());
+        }
+        m.print("region::samearea");
+    }
+    {
+        measurement m;
+        while(!m.done()) {
+            m.start();
+            for(const auto& pair : nearby)
+                sink = pair.first->has_intersect(*pair.second);
+            m.stop(nearby.size());
+        }
+        m.print("region::has_intersect");
+    }
+
+    //the sets are built and copied outside of the timed part
+    {
+        measurement m;
+        while(!m.done()) {
+            for(const snapshot& snap : snapshots) {
+                ms::region_set set(height, width);
+                m.start();
+                for(const ms::region& reg : snap.regions)
+                    sink = set.add(reg).first;
+                m.stop(snap.regions.size());
+            }
+        }
+        m.print("region_set::add");
+    }
+    {
+        measurement m;
+        std::vector<ms::region_set::handle> handles;
+        while(!m.done()) {
+            for(const snapshot& snap : snapshots) {
+                ms::region_set set(snap.set);
+                handles.clear();
+                for(ms::region_set::const_iterator it = set.begin(); it != set.end(); ++it)
+                    handles.push_back(it.get_handle());
+                m.start();
+                for(ms::region_set::handle h : handles)
+                    set.remove(h);
+                m.stop(handles.size());
+            }
+        }
+        m.print("region_set::remove");
+    }
+    if(total_safe > 0) {
+        measurement m;
+        while(!m.done()) {
+            for(const snapshot& snap : snapshots) {
+                ms::region_set set(snap.set);
+                m.start();
+                for(ms::rc_coord cell : snap.safe)
+                    sink = set.remove_safe(cell);
+                m.stop(snap.safe.size());
+            }
+        }
+        m.print("region_set::remove_safe");
+    }
+    {
+        measurement m;
+        ms::region_set::subset_type out;
+        while(!m.done()) {
+            for(const snapshot& snap : snapshots) {
+                m.start();
+                for(const ms::region& reg : snap.regions) {
+                    snap.set.regions_intersecting(reg, out);
+                    sink = out.size();
+                }
+                m.stop(snap.regions.size());
+            }
+        }
+        m.print("region_set::regions_intersecting");
+    }
+    {
+        measurement m;
+        while(!m.done()) {
+            m.start();
+            for(const snapshot& snap : snapshots)
+                sink = ms::solver(*snap.ai, ms::grid::SURFACE_COPY).width();
+            m.stop(snapshots.size());
+        }
+        m.print("solver(solver, SURFACE_COPY)");
+    }
+    {
+        measurement m;
+        ms::solver target(height, width, bombs);
+        while(!m.done()) {
+            m.start();
+            for(const snapshot& snap : snapshots)
+                snap.ai->refresh(target);
+            m.stop(snapshots.size());
+        }
+        m.print("solver::refresh_snapshot");
+    }
+}
@@ -0,0 +1,372 @@
+#include "monte_carlo.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ms {
+
+namespace {
+
+    /**a random index in `[0,n)`, the same on every platform for the same engine state**/
+    size_t pick(std::mt19937_64& rng, size_t n) {
+        return rng() % n;
+    }
+
+    /**a random number in `[0,1)`, the same on every platform for the same engine state**/
+    double unit(std::mt19937_64& rng) {
+        return (rng() >> 11) * (1.0 / (std::uint64_t(1) << 53));
+    }
+
+    /**log of the binomial coefficient \f$\binom{n}{k}\f$**/
+    double lchoose(unsigned n, unsigned k) {
+        return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+    }
+
+    /**how often the local search flips a random cell of an unmet region instead of the best one, so it does not get stuck**/
+    constexpr double INITIALIZE_NOISE = 0.2;
+
+}
+
+/**
+ * Initializes a sampler for a grid with the given dimensions. All probabilities are zero until `sample` is called.
+ **/
+monte_carlo::monte_carlo(unsigned height, unsigned width) :
+    width(width), probabilities(height * width, 0), intervals(height * width, 0) {}
+
+/**
+ * Estimates the probability of every cell of `g` being a bomb by sampling, using the chains on
+ * `pool` if it is not null. `regions` must hold the regions of `g`.
+ *
+ * Returns false, leaving the estimates unchanged and `converged` false, if no layout meeting every
+ * region was found.
+ *
+ * Complexity \f$O(S \cdot N)\f$ where \f$S\f$ is the number of samples and \f$N\f$ the number of
+ * cells in any region, bounded by the time budget.
+ **/
+bool monte_carlo::sample(const grid& g, const region_set& regions, thread_pool* pool) {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + time_budget;
+    _converged = false;
+    _samples = 0;
+
+    unsigned hidden = 0;
+    for(unsigned r = 0; r < g.height(); ++r) {
+        for(unsigned c = 0; c < g.width(); ++c) {
+            grid::cell value = g.get(r,c);
+            if(value == grid::ms_hidden || value == grid::ms_question)
+                ++hidden;
+        }
+    }
+    //the cells are numbered in the order they are first seen, before any member is changed
+    std::vector<int> index(probabilities.size(), -1);
+    size_t n = 0;
+    for(const region& reg : regions) {
+        for(rc_coord cell : reg) {
+            int& i = index[cell.row * width + cell.col];
+            if(i < 0)
+                i = n++;
+        }
+    }
+    if(n > hidden)
+        return false;
+
+    cells.resize(n);
+    constraints.clear();
+    cell_constraints.resize(n);
+    for(std::vector<unsigned>& of_cell : cell_constraints)
+        of_cell.clear();
+    for(const region& reg : regions) {
+        constraints.push_back(constraint{ reg.min(), reg.max(), {} });
+        for(rc_coord cell : reg) {
+            int i = index[cell.row * width + cell.col];
+            cells[i] = cell;
+            constraints.back().cells.push_back(i);
+            cell_constraints[i].push_back(constraints.size() - 1);
+        }
+    }
+    outside = hidden - n;
+    remaining = g.remaining_bombs();
+    log_ways.clear();
+    for(unsigned m = 0; m <= remaining; ++m)
+        log_ways.push_back(m <= outside ? lchoose(outside, m) : -std::numeric_limits<double>::infinity());
+
+    std::vector<double> sum(n + 1, 0), sum_sq(n + 1, 0);
+    unsigned batches = 0;
+    if(n > 0) {
+        std::vector<chain> chains(chain_count);
+        for(unsigned c = 0; c < chain_count; ++c) {
+            std::seed_seq seq{ std::uint32_t(_seed), std::uint32_t(_seed >> 32), std::uint32_t(c) };
+            chains[c].rng.seed(seq);
+        }
+        std::vector<unsigned char> started(chain_count, 0);
+        auto run = [&](bool record) {
+            auto job = [&](size_t begin, size_t end, unsigned) {
+                for(size_t c = begin; c < end; ++c) {
+                    if(!record)
+                        started[c] = initialize(chains[c]);
+                    if(started[c])
+                        run_batch(chains[c], record);
+                }
+            };
+            if(pool != nullptr)
+                pool->parallel_for(chains.size(), job);
+            else
+                job(0, chains.size(), 0);
+        };
+
+        //the first batch of every chain is discarded, so the chains can move away from where the search left them
+        run(false);
+        if(std::count(started.begin(), started.end(), 0) > 0)
+            return false;
+
+        while(!_converged && (batches < 2 || std::chrono::steady_clock::now() < deadline)) {
+            run(true);
+            for(const chain& ch : chains) {
+                for(size_t i = 0; i <= n; ++i) {
+                    double mean = ch.batch[i] / SWEEPS_PER_BATCH;
+                    sum[i] += mean;
+                    sum_sq[i] += mean * mean;
+                }
+                ++batches;
+            }
+            if(batches >= MIN_BATCHES) {
+                double widest = 0;
+                for(size_t i = 0; i <= n; ++i) {
+                    double variance = (sum_sq[i] - sum[i] * sum[i] / batches) / (batches - 1);
+                    widest = std::max(widest, 1.96 * std::sqrt(std::max(0.0, variance) / batches));
+                }
+                _converged = widest <= precision;
+            }
+        }
+    } else {
+        _converged = true;
+    }
+    _samples = size_t(batches) * SWEEPS_PER_BATCH;
+
+    auto mean = [&](size_t i) { return float(sum[i] / batches); };
+    auto half_width = [&](size_t i) {
+        if(batches < 2)
+            return 0.f;
+        double variance = (sum_sq[i] - sum[i] * sum[i] / batches) / (batches - 1);
+        return float(1.96 * std::sqrt(std::max(0.0, variance) / batches));
+    };
+    if(n == 0) {
+        _unconstrained = outside > 0 ? std::min(1.f, float(remaining) / outside) : 0;
+        _unconstrained_interval = 0;
+    } else {
+        _unconstrained = mean(n);
+        _unconstrained_interval = half_width(n);
+    }
+
+    for(unsigned r = 0; r < g.height(); ++r) {
+        for(unsigned c = 0; c < g.width(); ++c) {
+            size_t p = r * width + c;
+            intervals[p] = 0;
+            switch(g.get(r,c)) {
+            case grid::ms_hidden:
+            case grid::ms_question:
+                if(index[p] < 0) {
+                    probabilities[p] = _unconstrained;
+                    intervals[p] = _unconstrained_interval;
+                } else {
+                    probabilities[p] = mean(index[p]);
+                    intervals[p] = half_width(index[p]);
+                }
+                break;
+            case grid::ms_flag:
+                probabilities[p] = 1;
+                break;
+            default:
+                probabilities[p] = 0;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Finds a layout meeting every region and the number of bombs left with a local search: while some
+ * region has too few (or too many) bombs, one of its cells is flipped, usually the one that leaves
+ * the fewest regions unmet. Returns false if no layout was found in a bounded number of flips.
+ **/
+bool monte_carlo::initialize(chain& ch) const {
+    size_t n = cells.size();
+    ch.value.assign(n, 0);
+    ch.bombs.assign(constraints.size(), 0);
+    ch.total = 0;
+    ch.in_block.assign(n, -1);
+    ch.unassigned.assign(constraints.size(), 0);
+
+    std::vector<unsigned> violated;
+    std::vector<int> position(constraints.size(), -1);
+    auto update = [&](unsigned c) {
+        bool unmet = ch.bombs[c] < constraints[c].min || ch.bombs[c] > constraints[c].max;
+        if(unmet && position[c] < 0) {
+            position[c] = violated.size();
+            violated.push_back(c);
+        } else if(!unmet && position[c] >= 0) {
+            position[violated.back()] = position[c];
+            violated[position[c]] = violated.back();
+            violated.pop_back();
+            position[c] = -1;
+        }
+    };
+    auto flip_and_update = [&](unsigned cell) {
+        flip(ch, cell);
+        for(unsigned c : cell_constraints[cell])
+            update(c);
+    };
+    for(unsigned c = 0; c < constraints.size(); ++c)
+        update(c);
+
+    std::vector<unsigned> candidates;
+    for(size_t steps = 0; steps < 100 * n + 10000; ++steps) {
+        if(violated.empty()) {
+            if(ch.total <= remaining && remaining - ch.total <= outside)
+                return true;
+            //too many (or too few) bombs in total, try to remove (or add) one anywhere
+            unsigned cell = pick(ch.rng, n);
+            if(ch.value[cell] == (ch.total > remaining))
+                flip_and_update(cell);
+            continue;
+        }
+        const constraint& con = constraints[violated[pick(ch.rng, violated.size())]];
+        unsigned char from = ch.bombs[&con - constraints.data()] < con.min ? 0 : 1;
+        candidates.clear();
+        for(unsigned cell : con.cells) {
+            if(ch.value[cell] == from)
+                candidates.push_back(cell);
+        }
+        unsigned chosen = candidates[pick(ch.rng, candidates.size())];
+        if(unit(ch.rng) >= INITIALIZE_NOISE) {
+            unsigned fewest = ~0u;
+            for(unsigned cell : candidates) {
+                unsigned unmet = 0;
+                for(unsigned c : cell_constraints[cell]) {
+                    unsigned bombs = ch.bombs[c] + (from ? -1 : 1);
+                    unmet += bombs < constraints[c].min || bombs > constraints[c].max;
+                }
+                if(unmet < fewest) {
+                    fewest = unmet;
+                    chosen = cell;
+                }
+            }
+        }
+        flip_and_update(chosen);
+    }
+    return false;
+}
+
+void monte_carlo::flip(chain& ch, unsigned cell) const {
+    ch.value[cell] ^= 1;
+    if(ch.value[cell]) {
+        ++ch.total;
+        for(unsigned c : cell_constraints[cell])
+            ++ch.bombs[c];
+    } else {
+        --ch.total;
+        for(unsigned c : cell_constraints[cell])
+            --ch.bombs[c];
+    }
+}
+
+/**
+ * Draws the block of a random cell again (a heat bath move). The cells of the block are cleared,
+ * and one of the assignments of the block meeting every region is chosen with `draw_block`.
+ **/
+void monte_carlo::step(chain& ch) const {
+    unsigned first = pick(ch.rng, cells.size());
+    ch.block.clear();
+    ch.block.push_back(first);
+    ch.in_block[first] = 0;
+    for(size_t pos = 0; pos < ch.block.size() && ch.block.size() < BLOCK_SIZE; ++pos) {
+        for(unsigned c : cell_constraints[ch.block[pos]]) {
+            for(unsigned cell : constraints[c].cells) {
+                if(ch.block.size() == BLOCK_SIZE)
+                    break;
+                if(ch.in_block[cell] < 0) {
+                    ch.in_block[cell] = ch.block.size();
+                    ch.block.push_back(cell);
+                }
+            }
+        }
+    }
+    //the current assignment meets every region, so it is kept if every other one is far less likely
+    double base = log_ways[remaining - ch.total];
+    ch.chosen.clear();
+    for(unsigned cell : ch.block) {
+        ch.chosen.push_back(ch.value[cell]);
+        if(ch.value[cell])
+            flip(ch, cell);
+        for(unsigned c : cell_constraints[cell])
+            ++ch.unassigned[c];
+    }
+
+    ch.total_weight = 0;
+    draw_block(ch, 0, base);
+    for(size_t pos = 0; pos < ch.block.size(); ++pos) {
+        unsigned cell = ch.block[pos];
+        if(ch.value[cell] != ch.chosen[pos])
+            flip(ch, cell);
+        for(unsigned c : cell_constraints[cell])
+            --ch.unassigned[c];
+        ch.in_block[cell] = -1;
+    }
+}
+
+/**
+ * Assigns the cells of the block from `pos` on in every way that meets the regions, and chooses
+ * one of the complete assignments into `chosen`, each in proportion to its weight relative to
+ * `exp(base)` (weighted reservoir sampling, keeping one).
+ **/
+void monte_carlo::draw_block(chain& ch, size_t pos, double base) const {
+    if(pos == ch.block.size()) {
+        unsigned left = remaining - ch.total;
+        if(left > outside)
+            return;
+        double weight = std::exp(log_ways[left] - base);
+        ch.total_weight += weight;
+        if(unit(ch.rng) * ch.total_weight < weight) {
+            for(size_t p = 0; p < ch.block.size(); ++p)
+                ch.chosen[p] = ch.value[ch.block[p]];
+        }
+        return;
+    }
+    unsigned cell = ch.block[pos];
+    for(unsigned char v = 0; v <= 1; ++v) {
+        if(v == 1) {
+            if(ch.total == remaining)
+                break;
+            flip(ch, cell);
+        }
+        bool fits = true;
+        for(unsigned c : cell_constraints[cell]) {
+            --ch.unassigned[c];
+            if(ch.bombs[c] > constraints[c].max || ch.bombs[c] + ch.unassigned[c] < constraints[c].min)
+                fits = false;
+        }
+        if(fits)
+            draw_block(ch, pos + 1, base);
+        for(unsigned c : cell_constraints[cell])
+            ++ch.unassigned[c];
+    }
+    if(ch.value[cell])
+        flip(ch, cell);
+}
+
+/**Makes `SWEEPS_PER_BATCH` sweeps of moves, and sums the samples after each sweep into `batch` if `record` is true.**/
+void monte_carlo::run_batch(chain& ch, bool record) const {
+    size_t n = cells.size();
+    if(record)
+        ch.batch.assign(n + 1, 0);
+    for(unsigned sweep = 0; sweep < SWEEPS_PER_BATCH; ++sweep) {
+        for(size_t s = 0; s < n; ++s)
+            step(ch);
+        if(record) {
+            for(size_t i = 0; i < n; ++i)
+                ch.batch[i] += ch.value[i];
+            ch.batch[n] += outside > 0 ? double(remaining - ch.total) / outside : 0;
+        }
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+#ifndef MS_MONTE_CARLO_H
+#define MS_MONTE_CARLO_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "grid.h"
+#include "region_set.h"
+#include "thread_pool.h"
+
+namespace ms {
+
+/**
+ * Estimates the probability that each cell of a grid is a bomb by sampling bomb layouts, for
+ * frontiers too large to enumerate (see `probability_map`).
+ *
+ * Layouts of the cells in any region are drawn by several Markov chains. Each chain starts from
+ * a layout meeting every region, found by a local search. Every move then picks a random cell and
+ * draws the cells sharing a region with it (a block of at most `BLOCK_SIZE` cells) again, from
+ * all assignments of the block that meet every region given the rest of the layout. Assignments
+ * are weighted by the number of ways the other bombs can be placed in the hidden cells outside of
+ * every region, so layouts are drawn in proportion to how many complete grids agree with them.
+ *
+ * The samples of each chain are averaged in batches, and the spread of the batch averages gives a
+ * 95% confidence interval for every cell. Sampling stops once every interval is narrower than the
+ * precision, or when the time budget runs out.
+ *
+ * Every chain has its own random engine, seeded from the seed and the index of the chain, and the
+ * chains are combined in order, so the results only depend on the seed and the number of chains,
+ * not on the number of threads. A run stopped by the time budget may have drawn fewer batches.
+ **/
+class monte_carlo {
+public:
+    static constexpr float DEFAULT_PRECISION = 0.02f;
+    static constexpr unsigned DEFAULT_CHAINS = 4;
+    static constexpr std::chrono::milliseconds DEFAULT_TIME_BUDGET{ 200 };
+    /**most cells drawn again by one move**/
+    static constexpr unsigned BLOCK_SIZE = 16;
+    /**sweeps of every frontier cell averaged into one batch**/
+    static constexpr unsigned SWEEPS_PER_BATCH = 16;
+    /**fewest batches, over all chains, before sampling can stop for precision**/
+    static constexpr unsigned MIN_BATCHES = 16;
+
+    monte_carlo(unsigned height, unsigned width);
+
+    bool sample(const grid& g, const region_set& regions, thread_pool* pool = nullptr);
+
+    /**Returns the estimated probability that the cell is a bomb, as of the last call to `sample`.\n Complexity \f$O(1)\f$**/
+    float get(rc_coord cell) const { return probabilities[cell.row * width + cell.col]; }
+    /**Returns the half width of the 95% confidence interval of `get(cell)`.\n Complexity \f$O(1)\f$**/
+    float interval(rc_coord cell) const { return intervals[cell.row * width + cell.col]; }
+    /**Returns the estimated probability that a hidden cell outside of every region is a bomb.\n Complexity \f$O(1)\f$**/
+    float unconstrained() const { return _unconstrained; }
+    /**Returns the half width of the 95% confidence interval of `unconstrained()`.\n Complexity \f$O(1)\f$**/
+    float unconstrained_interval() const { return _unconstrained_interval; }
+    /**Returns the number of layouts averaged in the last call to `sample`.\n Complexity \f$O(1)\f$**/
+    size_t samples() const { return _samples; }
+    /**Returns true if the last call to `sample` met the precision before the time budget ran out.\n Complexity \f$O(1)\f$**/
+    bool converged() const { return _converged; }
+
+    void set_seed(std::uint64_t seed) { _seed = seed; }
+    std::uint64_t seed() const { return _seed; }
+    /**Sets the widest confidence interval half width (of any cell) at which sampling stops.**/
+    void set_precision(float half_width) { precision = half_width; }
+    void set_time_budget(std::chrono::milliseconds budget) { time_budget = budget; }
+    /**Sets the number of chains, which is also the most threads used. 0 is treated as 1.**/
+    void set_chains(unsigned chains) { chain_count = chains > 0 ? chains : 1; }
+
+private:
+    struct constraint {
+        unsigned min, max;
+        std::vector<unsigned> cells;
+    };
+
+    /**the state of one Markov chain**/
+    struct chain {
+        std::mt19937_64 rng;
+        std::vector<unsigned char> value;
+        /**the number of bombs in each constraint**/
+        std::vector<unsigned> bombs;
+        /**the number of bombs on the frontier**/
+        unsigned total = 0;
+        /**the sum of the samples of the current batch, one per frontier cell and the last for the unconstrained cells**/
+        std::vector<double> batch;
+
+        //scratch space for `step`
+        std::vector<unsigned> block;
+        /**position of each frontier cell in `block`, or -1**/
+        std::vector<int> in_block;
+        /**the number of cells of each constraint in `block` that are not assigned yet**/
+        std::vector<unsigned> unassigned;
+        std::vector<unsigned char> chosen;
+        double total_weight;
+    };
+
+    unsigned width;
+    std::vector<float> probabilities;
+    std::vector<float> intervals;
+    float _unconstrained = 0;
+    float _unconstrained_interval = 0;
+    size_t _samples = 0;
+    bool _converged = false;
+
+    std::uint64_t _seed = 0;
+    float precision = DEFAULT_PRECISION;
+    std::chrono::milliseconds time_budget = DEFAULT_TIME_BUDGET;
+    unsigned chain_count = DEFAULT_CHAINS;
+
+    //the problem being sampled, set up by `sample`
+    std::vector<rc_coord> cells;
+    std::vector<constraint> constraints;
+    std::vector<std::vector<unsigned>> cell_constraints;
+    /**hidden cells outside of every region**/
+    unsigned outside;
+    unsigned remaining;
+    /**`log_ways[m]` is the log of the number of ways to place `m` bombs outside of every region**/
+    std::vector<double> log_ways;
+
+    bool initialize(chain& ch) const;
+    void flip(chain& ch, unsigned cell) const;
+    void step(chain& ch) const;
+    void draw_block(chain& ch, size_t pos, double base) const;
+    void run_batch(chain& ch, bool record) const;
+};
+
+}
+
+#endif //MS_MONTE_CARLO_H
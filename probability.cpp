@@ -0,0 +1,360 @@
+#include "probability.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ms {
+
+namespace {
+
+    /**
+     * Depth first search over the bomb/safe assignments of the cells of a component, in the
+     * order given by `order`. Keeps the number of bombs assigned and cells not yet assigned of
+     * every region, and backtracks as soon as a region's range can no longer be met.
+     **/
+    struct backtracker {
+        struct constraint {
+            unsigned min, max, assigned, unassigned;
+        };
+
+        std::vector<constraint> constraints;
+        /**the constraints of the cell at each position of `order`**/
+        std::vector<std::vector<unsigned>> cell_constraints;
+        std::vector<unsigned> order;
+        std::vector<unsigned char> value;
+        std::vector<double>& counts;
+        std::vector<std::vector<double>>& cell_counts;
+        unsigned max_bombs;
+        size_t nodes_left;
+        unsigned bombs = 0;
+
+        backtracker(std::vector<double>& counts, std::vector<std::vector<double>>& cell_counts, unsigned max_bombs, size_t budget) :
+            counts(counts), cell_counts(cell_counts), max_bombs(max_bombs), nodes_left(budget) {}
+
+        /**Returns false if the node budget ran out**/
+        bool run(size_t pos) {
+            if(nodes_left == 0)
+                return false;
+            --nodes_left;
+            size_t n = order.size();
+            if(pos == n) {
+                counts[bombs] += 1;
+                std::vector<double>& cells = cell_counts[bombs];
+                if(cells.empty())
+                    cells.assign(n, 0);
+                for(size_t p = 0; p < n; ++p) {
+                    if(value[p])
+                        cells[order[p]] += 1;
+                }
+                return true;
+            }
+            for(unsigned v = 0; v <= 1; ++v) {
+                if(v == 1 && bombs == max_bombs)
+                    break;
+                bool ok = true;
+                for(unsigned c : cell_constraints[pos]) {
+                    constraint& con = constraints[c];
+                    con.assigned += v;
+                    --con.unassigned;
+                    if(con.assigned > con.max || con.assigned + con.unassigned < con.min)
+                        ok = false;
+                }
+                if(ok) {
+                    value[pos] = v;
+                    bombs += v;
+                    if(!run(pos + 1))
+                        return false;
+                    bombs -= v;
+                }
+                for(unsigned c : cell_constraints[pos]) {
+                    constraints[c].assigned -= v;
+                    ++constraints[c].unassigned;
+                }
+            }
+            return true;
+        }
+    };
+
+    /**log of the binomial coefficient \f$\binom{n}{k}\f$**/
+    double lchoose(unsigned n, unsigned k) {
+        return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+    }
+
+    /**Convolution of two distributions over a number of bombs, scaled so the largest entry is 1**/
+    std::vector<double> convolve(const std::vector<double>& a, const std::vector<double>& b) {
+        std::vector<double> ret(a.size() + b.size() - 1, 0);
+        for(size_t i = 0; i < a.size(); ++i) {
+            if(a[i] == 0)
+                continue;
+            for(size_t j = 0; j < b.size(); ++j) {
+                ret[i + j] += a[i] * b[j];
+            }
+        }
+        double max = *std::max_element(ret.begin(), ret.end());
+        if(max > 0) {
+            for(double& x : ret)
+                x /= max;
+        }
+        return ret;
+    }
+
+}
+
+/**
+ * Initializes a map for a grid with the given dimensions. All probabilities are zero until `compute` is called.
+ **/
+probability_map::probability_map(unsigned height, unsigned width) :
+    width(width), probabilities(height * width, 0), sampler(height, width), component_of_root(height * width, -1), local_index(height * width, -1) {}
+
+/**
+ * Computes the probability of every cell of `g` being a bomb. `regions` must hold the regions
+ * of `g`, and `components` is rebuilt from them.
+ *
+ * If the regions have no consistent assignment with the bombs left, every hidden cell is estimated
+ * from its smallest regions instead and `is_exact` returns false.
+ *
+ * If a component was estimated and sampling is enabled, the probabilities are sampled instead, with
+ * the chains run on `pool` if it is not null.
+ *
+ * Complexity exponential in the size of the largest component in the worst case, bounded by the node budget.
+ * Combining the components is \f$O(C \cdot F^2)\f$ where \f$C\f$ is the number of components and \f$F\f$ the
+ * number of cells in any region.
+ **/
+void probability_map::compute(const grid& g, const region_set& regions, frontier& components, thread_pool* pool) {
+    components.build(regions);
+    _sampled = false;
+
+    std::vector<component> comps;
+    for(region_set::const_iterator it = regions.begin(); it != regions.end(); ++it) {
+        int& ci = component_of_root[components.find(*it->begin())];
+        if(ci < 0) {
+            ci = comps.size();
+            comps.emplace_back();
+        }
+        component& comp = comps[ci];
+        comp.constraints.push_back(it.get_handle());
+        for(rc_coord cell : *it) {
+            int& li = local_index[cell.row * width + cell.col];
+            if(li < 0) {
+                li = comp.cells.size();
+                comp.cells.push_back(cell);
+            }
+        }
+    }
+
+    unsigned hidden = 0;
+    for(unsigned r = 0; r < g.height(); ++r) {
+        for(unsigned c = 0; c < g.width(); ++c) {
+            switch(g.get(r,c)) {
+            case grid::ms_hidden:
+            case grid::ms_question:
+                ++hidden;
+                break;
+            case grid::ms_flag:
+                probabilities[r * width + c] = 1;
+                break;
+            default:
+                probabilities[r * width + c] = 0;
+            }
+        }
+    }
+
+    unsigned remaining = g.remaining_bombs();
+    size_t frontier_size = 0;
+    _exact = true;
+    for(component& comp : comps) {
+        frontier_size += comp.cells.size();
+        comp.exact = enumerate(comp, regions, remaining);
+        if(!comp.exact) {
+            estimate(comp, regions);
+            _exact = false;
+        }
+    }
+    assert(frontier_size <= hidden);
+    unsigned unconstrained_cells = hidden - frontier_size;
+
+    //weights[K]: number of ways to place the other bombs in the unconstrained cells if the components hold K
+    std::vector<double> weights(frontier_size + 1, 0);
+    double max_weight = -std::numeric_limits<double>::infinity();
+    for(size_t k = 0; k <= frontier_size && k <= remaining; ++k) {
+        if(remaining - k <= unconstrained_cells)
+            max_weight = std::max(max_weight, lchoose(unconstrained_cells, remaining - k));
+    }
+    for(size_t k = 0; k <= frontier_size && k <= remaining; ++k) {
+        if(remaining - k <= unconstrained_cells)
+            weights[k] = std::exp(lchoose(unconstrained_cells, remaining - k) - max_weight);
+    }
+
+    //prefix[c] and suffix[c] are the distributions of the bombs in the components before and from c
+    std::vector<std::vector<double>> prefix(comps.size() + 1), suffix(comps.size() + 1);
+    prefix[0] = suffix[comps.size()] = std::vector<double>(1, 1);
+    for(size_t c = 0; c < comps.size(); ++c) {
+        prefix[c + 1] = convolve(prefix[c], comps[c].counts);
+    }
+    for(size_t c = comps.size(); c-- > 0;) {
+        suffix[c] = convolve(comps[c].counts, suffix[c + 1]);
+    }
+
+    bool consistent = true;
+    for(size_t c = 0; c < comps.size() && consistent; ++c) {
+        component& comp = comps[c];
+        size_t n = comp.cells.size();
+        std::vector<double> rest = convolve(prefix[c], suffix[c + 1]);
+        //outside[k]: relative weight of everything outside of the component if it holds k bombs
+        std::vector<double> outside(n + 1, 0);
+        double total = 0;
+        for(size_t k = 0; k <= n; ++k) {
+            for(size_t j = 0; j < rest.size(); ++j) {
+                outside[k] += rest[j] * weights[k + j];
+            }
+            total += comp.counts[k] * outside[k];
+        }
+        if(total <= 0) {
+            consistent = false;
+            break;
+        }
+        std::vector<double> bomb(n, 0);
+        for(size_t k = 0; k <= n; ++k) {
+            for(size_t i = 0; i < comp.cell_counts[k].size(); ++i)
+                bomb[i] += comp.cell_counts[k][i] * outside[k];
+        }
+        for(size_t i = 0; i < n; ++i) {
+            rc_coord cell = comp.cells[i];
+            probabilities[cell.row * width + cell.col] = bomb[i] / total;
+        }
+    }
+
+    const std::vector<double>& all = prefix.back();
+    double expected = 0, total = 0;
+    for(size_t k = 0; k < all.size(); ++k) {
+        if(k <= remaining) {
+            expected += (remaining - k) * all[k] * weights[k];
+            total += all[k] * weights[k];
+        }
+    }
+    consistent = consistent && total > 0;
+    if(!consistent) {
+        _exact = false;
+        for(component& comp : comps) {
+            for(rc_coord cell : comp.cells)
+                probabilities[cell.row * width + cell.col] = local_estimate(cell, regions);
+        }
+        _unconstrained = hidden > 0 ? std::min(1.f, float(remaining) / hidden) : 0;
+    } else {
+        _unconstrained = unconstrained_cells > 0 ? expected / total / unconstrained_cells : 0;
+    }
+
+    for(unsigned r = 0; r < g.height(); ++r) {
+        for(unsigned c = 0; c < g.width(); ++c) {
+            grid::cell value = g.get(r,c);
+            if((value == grid::ms_hidden || value == grid::ms_question) && local_index[r * width + c] < 0)
+                probabilities[r * width + c] = _unconstrained;
+        }
+    }
+
+    for(component& comp : comps) {
+        component_of_root[components.find(comp.cells.front())] = -1;
+        for(rc_coord cell : comp.cells)
+            local_index[cell.row * width + cell.col] = -1;
+    }
+
+    if(!_exact && sampling && sampler.sample(g, regions, pool)) {
+        _sampled = true;
+        _unconstrained = sampler.unconstrained();
+        for(unsigned r = 0; r < g.height(); ++r) {
+            for(unsigned c = 0; c < g.width(); ++c)
+                probabilities[r * width + c] = sampler.get(rc_coord(r, c));
+        }
+    }
+}
+
+/**
+ * Counts the assignments of a component by their number of bombs, up to `max_bombs`.
+ * Returns false, leaving the counts incomplete, if the node budget runs out first.
+ *
+ * Cells are assigned in breadth first order through the regions, so regions are completed
+ * (and pruned) early.
+ **/
+bool probability_map::enumerate(component& comp, const region_set& regions, unsigned max_bombs) {
+    size_t n = comp.cells.size();
+    comp.counts.assign(n + 1, 0);
+    comp.cell_counts.assign(n + 1, std::vector<double>());
+
+    backtracker search(comp.counts, comp.cell_counts, max_bombs, budget);
+    std::vector<std::vector<unsigned>> constraint_cells(comp.constraints.size()), by_cell(n);
+    for(unsigned c = 0; c < comp.constraints.size(); ++c) {
+        const region& reg = regions[comp.constraints[c]];
+        search.constraints.push_back(backtracker::constraint{ reg.min(), reg.max(), 0, unsigned(reg.size()) });
+        for(rc_coord cell : reg) {
+            unsigned i = local_index[cell.row * width + cell.col];
+            constraint_cells[c].push_back(i);
+            by_cell[i].push_back(c);
+        }
+    }
+
+    std::vector<unsigned char> seen(n, 0);
+    search.order.push_back(0);
+    seen[0] = 1;
+    for(size_t q = 0; q < search.order.size(); ++q) {
+        for(unsigned c : by_cell[search.order[q]]) {
+            for(unsigned i : constraint_cells[c]) {
+                if(!seen[i]) {
+                    seen[i] = 1;
+                    search.order.push_back(i);
+                }
+            }
+        }
+    }
+    assert(search.order.size() == n);
+    for(unsigned i : search.order)
+        search.cell_constraints.push_back(by_cell[i]);
+    search.value.assign(n, 0);
+
+    return search.run(0);
+}
+
+/**
+ * Fills in the counts of a component that was too large to enumerate, from the estimate of each of
+ * its cells. The component is treated as always holding the expected number of bombs.
+ **/
+void probability_map::estimate(component& comp, const region_set& regions) {
+    size_t n = comp.cells.size();
+    std::vector<double> estimates;
+    double expected = 0;
+    for(rc_coord cell : comp.cells) {
+        estimates.push_back(local_estimate(cell, regions));
+        expected += estimates.back();
+    }
+    size_t k = std::min<size_t>(n, std::lround(expected));
+    comp.counts.assign(n + 1, 0);
+    comp.cell_counts.assign(n + 1, std::vector<double>());
+    comp.counts[k] = 1;
+    comp.cell_counts[k] = std::move(estimates);
+}
+
+/**
+ * Estimates the probability of a cell from the smallest regions containing it, which are the most
+ * relevant, as the average of the middle of their ranges.
+ **/
+float probability_map::local_estimate(rc_coord cell, const region_set& regions) const {
+    const region* smallest = nullptr;
+    float sum = 0;
+    unsigned count = 0;
+    for(region_set::handle h : regions.regions_intersecting(cell)) {
+        const region& reg = regions[h];
+        if(smallest == nullptr || reg.size() < smallest->size()) {
+            smallest = &reg;
+            sum = 0;
+            count = 0;
+        }
+        if(reg.size() == smallest->size()) {
+            sum += reg.min() + reg.max();
+            ++count;
+        }
+    }
+    if(count == 0)
+        return _unconstrained;
+    return sum / (2 * count * smallest->size());
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef MS_PROBABILITY_H
+#define MS_PROBABILITY_H
+
+#include <cstddef>
+#include <vector>
+#include "grid.h"
+#include "region.h"
+#include "region_set.h"
+#include "frontier.h"
+#include "monte_carlo.h"
+#include "thread_pool.h"
+
+namespace ms {
+
+/**
+ * The probability that each cell of a grid is a bomb, given the visible grid and the regions
+ * known about it.
+ *
+ * Every frontier component (see `frontier`) is solved on its own: its cells are assigned
+ * bomb or safe by backtracking, pruning as soon as a region can no longer be satisfied, and the
+ * consistent assignments are counted by their number of bombs. The components and the hidden
+ * cells outside of any region are then combined with the number of bombs left on the grid, where
+ * an assignment of the components with \f$K\f$ bombs in total can be completed in
+ * \f$\binom{U}{R - K}\f$ ways. These binomials are computed in log space, so large grids do not
+ * overflow.
+ *
+ * Components with more backtracking nodes than the node budget are not enumerated. Their cells
+ * are estimated from the smallest regions containing them and `is_exact` returns false. If
+ * sampling is enabled, the whole frontier is then sampled instead (see `monte_carlo`), and
+ * `interval` gives the precision of each cell.
+ **/
+class probability_map {
+public:
+    static constexpr size_t DEFAULT_NODE_BUDGET = 1 << 20;
+
+    probability_map(unsigned height, unsigned width);
+
+    void compute(const grid& g, const region_set& regions, frontier& components, thread_pool* pool = nullptr);
+
+    /**
+     * Returns the probability that the cell is a bomb, as of the last call to `compute`.
+     * Opened cells are 0 and flagged cells are 1.\n Complexity \f$O(1)\f$
+     **/
+    float get(rc_coord cell) const { return probabilities[cell.row * width + cell.col]; }
+    /**Returns the probability that a hidden cell outside of every region is a bomb.\n Complexity \f$O(1)\f$**/
+    float unconstrained() const { return _unconstrained; }
+    /**Returns true if no component was estimated in the last call to `compute`.\n Complexity \f$O(1)\f$**/
+    bool is_exact() const { return _exact; }
+    /**
+     * Returns the half width of the 95% confidence interval of `get(cell)` if it was sampled in the
+     * last call to `compute`, and 0 otherwise.\n Complexity \f$O(1)\f$
+     **/
+    float interval(rc_coord cell) const { return _sampled ? sampler.interval(cell) : 0; }
+    /**Returns true if the frontier was sampled in the last call to `compute`.\n Complexity \f$O(1)\f$**/
+    bool is_sampled() const { return _sampled; }
+
+    /**Sets the most backtracking nodes spent on one component before it is estimated instead.\n Complexity \f$O(1)\f$**/
+    void set_node_budget(size_t nodes) { budget = nodes; }
+    size_t node_budget() const { return budget; }
+    /**Sets whether the frontier is sampled when a component is too large to enumerate.\n Complexity \f$O(1)\f$**/
+    void set_sampling(bool enabled) { sampling = enabled; }
+    bool get_sampling() const { return sampling; }
+    /**Returns the sampler used when sampling is enabled, to set its seed, precision and time budget.**/
+    monte_carlo& get_sampler() { return sampler; }
+
+private:
+    struct component {
+        std::vector<rc_coord> cells;
+        std::vector<region_set::handle> constraints;
+        /**`counts[k]` is the relative number of assignments of the component with `k` bombs**/
+        std::vector<double> counts;
+        /**`cell_counts[k][i]` is the part of `counts[k]` where cell `i` is a bomb. Empty where `counts[k]` is zero**/
+        std::vector<std::vector<double>> cell_counts;
+        bool exact;
+    };
+
+    unsigned width;
+    std::vector<float> probabilities;
+    float _unconstrained = 0;
+    bool _exact = true;
+    size_t budget = DEFAULT_NODE_BUDGET;
+    bool sampling = false;
+    bool _sampled = false;
+    monte_carlo sampler;
+
+    //scratch space for `compute`, indexed by `row * width + col`
+    std::vector<int> component_of_root;
+    std::vector<int> local_index;
+
+    bool enumerate(component& comp, const region_set& regions, unsigned max_bombs);
+    void estimate(component& comp, const region_set& regions);
+    float local_estimate(rc_coord cell, const region_set& regions) const;
+};
+
+}
+
+#endif //MS_PROBABILITY_H
@@ -4,16 +4,348 @@
 
 namespace ms {
 
+	/**
+	 * Returns a mask with the columns `[0, n)` of every row of the window set.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::cols_below(unsigned n) {
+		return ((std::uint64_t(1) << n) - 1) * 0x0101010101010101ull;
+	}
+
+	/**
+	 * Returns a mask of the columns occupied by any row of `mask` in the low 8 bits.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::fold_columns(std::uint64_t mask) {
+		mask |= mask >> 32;
+		mask |= mask >> 16;
+		mask |= mask >> 8;
+		return mask & 0xff;
+	}
+
+	/**
+	 * Moves every cell of `mask` by `dr` rows and `dc` columns. Cells that leave the
+	 * window are dropped.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::shift_window(std::uint64_t mask, long long dr, long long dc) {
+		if(dr <= -(long long)WINDOW || dr >= (long long)WINDOW || dc <= -(long long)WINDOW || dc >= (long long)WINDOW)
+			return 0;
+		if(dc > 0)
+			mask = (mask & cols_below(WINDOW - dc)) << dc;
+		else if(dc < 0)
+			mask = (mask & ~cols_below(-dc)) >> -dc;
+		if(dr > 0)
+			mask <<= dr * WINDOW;
+		else if(dr < 0)
+			mask >>= -dr * WINDOW;
+		return mask;
+	}
+
+	/**
+	 * Returns the mask of `arg` as seen from the window of `this`. Cells of `arg` outside
+	 * of the window are dropped. Neither region may be wide.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::aligned(const region& arg) const {
+		assert(!_is_wide && !arg._is_wide);
+		return shift_window(arg._mask,
+			(long long)arg._anchor.row - (long long)_anchor.row,
+			(long long)arg._anchor.col - (long long)_anchor.col);
+	}
+
+	/**
+	 * Finds the bit of `rc` in the window. Returns false if the cell is outside of the window.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	bool region::window_index(rc_coord rc, unsigned& index) const {
+		if(rc.row < _anchor.row || rc.col < _anchor.col)
+			return false;
+		unsigned dr = rc.row - _anchor.row, dc = rc.col - _anchor.col;
+		if(dr >= WINDOW || dc >= WINDOW)
+			return false;
+		index = dr * WINDOW + dc;
+		return true;
+	}
+
+	/**
+	 * Moves the anchor to the smallest row and column of the region, restoring the
+	 * canonical form after cells have been removed.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	void region::normalize() {
+		if(_mask == 0) {
+			_anchor = rc_coord();
+			return;
+		}
+		unsigned dr = __builtin_ctzll(_mask) / WINDOW;
+		unsigned dc = __builtin_ctzll(fold_columns(_mask));
+		if(dr != 0 || dc != 0) {
+			_mask = shift_window(_mask, -(long long)dr, -(long long)dc);
+			_anchor = rc_coord(_anchor.row + dr, _anchor.col + dc);
+		}
+	}
+
+	/**
+	 * Moves the cells of the mask into `_wide`.
+	 *
+	 * Complexity \f$O(N \cdot log(N))\f$
+	 **/
+	void region::make_wide() {
+		assert(!_is_wide);
+		_wide_hash = 0;
+		for(const_iterator it(_mask, _anchor), end(0, _anchor); it != end; ++it) {
+			_wide.insert(_wide.end(), *it);
+			_wide_hash ^= cell_key(*it);
+		}
+		_mask = 0;
+		_anchor = rc_coord();
+		_is_wide = true;
+	}
+
+	/**
+	 * Moves the cells of `_wide` back into the mask if they fit in the window.
+	 *
+	 * Complexity \f$O(N)\f$ if \f$N \leq 64\f$, otherwise \f$O(1)\f$
+	 **/
+	void region::try_make_narrow() {
+		assert(_is_wide);
+		if(_wide.size() > WINDOW * WINDOW)
+			return;
+		if(_wide.empty()) {
+			_wide_hash = 0;
+			_is_wide = false;
+			return;
+		}
+		unsigned min_row = _wide.begin()->row, max_row = _wide.rbegin()->row;
+		if(max_row - min_row >= WINDOW)
+			return;
+		unsigned min_col = _wide.begin()->col, max_col = min_col;
+		for(rc_coord cell : _wide) {
+			min_col = std::min(min_col, cell.col);
+			max_col = std::max(max_col, cell.col);
+		}
+		if(max_col - min_col >= WINDOW)
+			return;
+		_anchor = rc_coord(min_row, min_col);
+		_mask = 0;
+		for(rc_coord cell : _wide) {
+			_mask |= std::uint64_t(1) << ((cell.row - min_row) * WINDOW + cell.col - min_col);
+		}
+		_wide.clear();
+		_wide_hash = 0;
+		_is_wide = false;
+	}
+
+	/**
+	 * Removes a cell without adjusting `min` or `max`.
+	 *
+	 * Returns 1 if the cell was removed, 0 if it was not in the region.
+	 *
+	 * Complexity \f$O(1)\f$, \f$O(log(N))\f$ for wide regions
+	 **/
+	int region::erase_cell(rc_coord rc) {
+		if(_is_wide) {
+			if(_wide.erase(rc) == 0)
+				return 0;
+			_wide_hash ^= cell_key(rc);
+			try_make_narrow();
+			return 1;
+		}
+		unsigned index;
+		if(!window_index(rc, index) || !(_mask & (std::uint64_t(1) << index)))
+			return 0;
+		_mask &= ~(std::uint64_t(1) << index);
+		normalize();
+		return 1;
+	}
+
+	/**
+	 * splitmix64 finalizer, spreads the bits of `x` over the whole result.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::mix(std::uint64_t x) {
+		x += 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+
+	/**
+	 * Pseudo-random key of a single cell, the hash of a wide region is the XOR of the keys of its cells.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::cell_key(rc_coord rc) {
+		return mix((std::uint64_t(rc.row) << 32) | rc.col);
+	}
+
+	/**
+	 * Returns a hash of the cells of the region (`min` and `max` are not included), so that
+	 * `a.samearea(b)` implies `a.hash() == b.hash()`.
+	 *
+	 * Regions in the window hash their anchor and mask. Wide regions return the XOR of
+	 * the keys of their cells, which is kept up to date as cells are added and removed.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	std::uint64_t region::hash() const {
+		if(_is_wide)
+			return _wide_hash;
+		return mix(_mask ^ mix((std::uint64_t(_anchor.row) << 32) | _anchor.col));
+	}
 
 	/**
 	 * Adds a cell to a region if it is not contained already
 	 * 
 	 * Return 1 if it adds the cell, 0 otherwise
 	 * 
-	 * Complexity \f$O(log(N))\f$
+	 * Complexity \f$O(1)\f$, \f$O(log(N))\f$ for wide regions
 	 **/
 	int region::add_cell(rc_coord arg) {
-		return _cells.insert(arg).second;
+		if(_is_wide) {
+			if(!_wide.insert(arg).second)
+				return 0;
+			_wide_hash ^= cell_key(arg);
+			return 1;
+		}
+		if(_mask == 0) {
+			_anchor = arg;
+			_mask = 1;
+			return 1;
+		}
+		unsigned index = 0;
+		if(window_index(arg, index)) {
+			if(_mask & (std::uint64_t(1) << index))
+				return 0;
+			_mask |= std::uint64_t(1) << index;
+			return 1;
+		}
+		//the cell is outside the window, see if the window can be moved to cover it
+		std::uint64_t cols = fold_columns(_mask);
+		unsigned max_row = _anchor.row + (63 - __builtin_clzll(_mask)) / WINDOW;
+		unsigned max_col = _anchor.col + (63 - __builtin_clzll(cols));
+		rc_coord new_anchor(std::min(_anchor.row, arg.row), std::min(_anchor.col, arg.col));
+		if(std::max(max_row, arg.row) - new_anchor.row < WINDOW && std::max(max_col, arg.col) - new_anchor.col < WINDOW) {
+			_mask = shift_window(_mask,
+				(long long)_anchor.row - (long long)new_anchor.row,
+				(long long)_anchor.col - (long long)new_anchor.col);
+			_anchor = new_anchor;
+			window_index(arg, index);
+			_mask |= std::uint64_t(1) << index;
+		} else {
+			make_wide();
+			_wide.insert(arg);
+			_wide_hash ^= cell_key(arg);
+		}
+		return 1;
+	}
+
+	/**
+	 * Returns true if `cell` is in the region.
+	 *
+	 * Complexity \f$O(1)\f$, \f$O(log(N))\f$ for wide regions
+	 **/
+	bool region::contains(rc_coord cell) const {
+		if(_is_wide)
+			return _wide.find(cell) != _wide.end();
+		unsigned index;
+		return window_index(cell, index) && (_mask & (std::uint64_t(1) << index));
+	}
+
+	/**
+	 * Returns an iterator to `rc`, or `end()` if it is not in the region.
+	 *
+	 * Complexity \f$O(1)\f$, \f$O(log(N))\f$ for wide regions
+	 **/
+	region::const_iterator region::find(const rc_coord& rc) const {
+		if(_is_wide)
+			return const_iterator(_wide.find(rc));
+		unsigned index;
+		if(!window_index(rc, index) || !(_mask & (std::uint64_t(1) << index)))
+			return end();
+		return const_iterator(_mask & ~((std::uint64_t(1) << index) - 1), _anchor);
+	}
+
+	/**
+	 * Bounds of `a.intersect(b)` given the number of cells they have in common.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	region_bounds region::intersect_bounds(const region& a, const region& b, unsigned common) {
+		int subsize = a.size() - common;
+		int argsubsize = b.size() - common;
+
+		region_bounds ret;
+		ret.size = common;
+		ret.max = std::min<int>(std::min<int>(a._max, b._max), common);
+		ret.min = std::max<int>(
+			a._min - std::min<int>(subsize, a._min),
+			b._min - std::min<int>(argsubsize, b._min)
+		);
+		return ret;
+	}
+
+	/**
+	 * Bounds of `a.subtract(b)` given the number of cells they have in common.
+	 *
+	 * Complexity \f$O(1)\f$
+	 **/
+	region_bounds region::subtract_bounds(const region& a, const region& b, unsigned common) {
+		int remaining = a.size() - common;
+		int othersubsize = b.size() - common;
+
+		int intersect_min_given_max_bombs =  std::max(
+			a._max - std::min<int>(remaining, a._max),
+			b._min - std::min<int>(othersubsize, b._min) //we only assume `a` has max bombs
+		);
+
+		int intersect_max_given_min_bombs = std::min<int>(std::min<int>(a._min, b._max), common); //we only assume `a` has min bombs
+
+		region_bounds ret;
+		ret.size = remaining;
+		ret.max = std::min<int>(a._max - intersect_min_given_max_bombs, remaining);
+		ret.min = a._min - intersect_max_given_min_bombs;
+		return ret;
+	}
+
+	/**
+	 * Returns the number of cells in both regions.
+	 *
+	 * Complexity \f$O(1)\f$, \f$O(N \cdot log(M))\f$ if either region is wide
+	 **/
+	unsigned region::count_common(const region& arg) const {
+		if(!_is_wide && !arg._is_wide)
+			return __builtin_popcountll(_mask & aligned(arg));
+		const region& small = size() < arg.size() ? *this : arg;
+		const region& large = size() < arg.size() ? arg : *this;
+		unsigned common = 0;
+		for (rc_coord cell : small) {
+			common += large.contains(cell);
+		}
+		return common;
+	}
+
+	/**
+	 * Computes the size, `min` and `max` of `intersect(arg)`, `subtract(arg)` and `arg.subtract(*this)`
+	 * without building any of them, so callers can skip the ones that would not be helpful.
+	 *
+	 * Complexity \f$O(1)\f$, \f$O(N \cdot log(M))\f$ if either region is wide
+	 **/
+	region_split region::split(const region& arg) const {
+		unsigned common = count_common(arg);
+		region_split ret;
+		ret.common = intersect_bounds(*this, arg, common);
+		ret.this_only = subtract_bounds(*this, arg, common);
+		ret.arg_only = subtract_bounds(arg, *this, common);
+		return ret;
 	}
 
 	/**
@@ -21,24 +353,27 @@ namespace ms {
 	 * 
 	 * Throws bad_region_error if the resulting region fails is_reasonable()
 	 * 
-	 * Complexity \f$O(N \cdot log(M))\f$
+	 * Complexity \f$O(1)\f$, \f$O(N \cdot log(M))\f$ if either region is wide
 	 **/
 	region region::intersect(const region& arg) const {
 		region ret;
-		for (iterator it = begin(); it != end(); ++it) {
-			if(arg.find(*it) != arg.end()) {
-				ret.add_cell(*it);
+		if(!_is_wide && !arg._is_wide) {
+			ret._mask = _mask & aligned(arg);
+			ret._anchor = _anchor;
+			ret.normalize();
+		} else {
+			const region& small = size() < arg.size() ? *this : arg;
+			const region& large = size() < arg.size() ? arg : *this;
+			for (rc_coord cell : small) {
+				if(large.contains(cell)) {
+					ret.add_cell(cell);
+				}
 			}
 		}
 
-		int subsize = size() - ret.size();
-		int argsubsize = arg.size() - ret.size();
-
-		ret._max = std::min<int>(std::min<int>(_max, arg._max), ret.size());
-		ret._min = std::max<int>(
-			_min - std::min<int>(subsize, _min), 
-			arg._min - std::min<int>(argsubsize, arg._min)
-		);
+		region_bounds bounds = intersect_bounds(*this, arg, ret.size());
+		ret._max = bounds.max;
+		ret._min = bounds.min;
 
 		if(!is_reasonable()) {
 			throw bad_region_error("region intersection fails is_reasonable()");
@@ -53,14 +388,13 @@ namespace ms {
 	 * 
 	 * Throws bad_region_error if the resulting region fails is_reasonable()
 	 * 
-	 * Complexity \f$O(M \cdot log(M + N))\f$ where M is the size of `arg` and N is the size of `this`.
+	 * Complexity \f$O(M)\f$ where M is the size of `arg`, \f$O(M \cdot log(M + N))\f$ if the union is wide.
 	 **/
 	region region::unite(const region& arg) const {
-		region ret;
-		ret._cells = _cells;
+		region ret = *this;
 		int common = 0;
-		for (iterator it = arg.begin(); it != arg.end(); ++it) {
-			if (!ret.add_cell(*it))
+		for (rc_coord cell : arg) {
+			if (!ret.add_cell(cell))
 				++common;
 		}
 
@@ -83,27 +417,23 @@ namespace ms {
 	 * 
 	 * Throws bad_region_error if the resulting region fails is_reasonable()
 	 * 
-	 * Complexity \f$O(M \cdot log(M + N))\f$ where M is the size of `arg` and N is the size of `this`.
+	 * Complexity \f$O(1)\f$, \f$O(M \cdot log(M + N))\f$ if either region is wide, where M is the size of `arg` and N is the size of `this`.
 	 **/
 	region region::subtract(const region& arg) const {
 		region ret;
-		ret._cells = _cells;
-
-		for (iterator it = arg.begin(); it != arg.end(); ++it) {
-			ret.remove_safe(*it);
+		if(!_is_wide && !arg._is_wide) {
+			ret._mask = _mask & ~aligned(arg);
+			ret._anchor = _anchor;
+			ret.normalize();
+		} else {
+			ret = *this;
+			for (rc_coord cell : arg) {
+				ret.erase_cell(cell);
+			}
 		}
-		int common = size() - ret.size();
-		int othersubsize = arg.size() - common;
-
-		int intersect_min_given_max_bombs =  std::max(
-			_max - std::min<int>(ret.size(), _max), 
-			arg._min - std::min<int>(othersubsize, arg._min) //we only assume `this` has max bombs
-		);
-
-		int intersect_max_given_min_bombs = std::min<int>(std::min<int>(_min, arg._max), common); //we only assume `this` has min bombs
-
-		ret._max = std::min<int>(_max - intersect_min_given_max_bombs, ret.size()); 
-		ret._min = _min - intersect_max_given_min_bombs;
+		region_bounds bounds = subtract_bounds(*this, arg, size() - ret.size());
+		ret._max = bounds.max;
+		ret._min = bounds.min;
 
 		if(!is_reasonable()) {
 			throw bad_region_error("region subtraction fails is_reasonable()");
@@ -118,29 +448,21 @@ namespace ms {
 	 * 
 	 * Throws bad_region_error if the resulting region fails is_reasonable(), but subtraction still occurs
 	 *
-	 * Complexity \f$O(M \cdot log(M + N))\f$ where M is the size of `arg` and N is the size of `this`.
+	 * Complexity \f$O(1)\f$, \f$O(M \cdot log(M + N))\f$ if either region is wide, where M is the size of `arg` and N is the size of `this`.
 	 **/
 	region& region::subtract_to(const region& arg) {
-		size_t start_size = size();
-		unsigned start_min = min();
-		unsigned start_max = max();
-		set_count(0);//so that remove_safe does not throw
+		region_bounds bounds = subtract_bounds(*this, arg, count_common(arg));
 
-		for (iterator it = arg.begin(); it != arg.end(); ++it) {
-			remove_safe(*it);
+		if(!_is_wide && !arg._is_wide) {
+			_mask &= ~aligned(arg);
+			normalize();
+		} else {
+			for (rc_coord cell : arg) {
+				erase_cell(cell);
+			}
 		}
-		int common = start_size - size();
-		int othersubsize = arg.size() - common;
-
-		int intersect_min_given_max_bombs =  std::max(
-			start_max - std::min<int>(size(), start_max), 
-			arg._min - std::min<int>(othersubsize, arg._min) //we only assume `this` has max bombs
-		);
-
-		int intersect_max_given_min_bombs = std::min<int>(std::min<int>(start_min, arg._max), common); //we only assume `this` has min bombs
-
-		_max = std::min<int>(start_max - intersect_min_given_max_bombs, size()); 
-		_min = start_min - intersect_max_given_min_bombs;
+		_max = bounds.max;
+		_min = bounds.min;
 
 		if(!is_reasonable()) {
 			throw bad_region_error("region subtract_to fails is_reasonable()");
@@ -157,12 +479,12 @@ namespace ms {
 	 * 
 	 * Throws bad_region_error if the resulting region fails is_reasonable(), but subtraction still occurs
 	 * 
-	 * Complexity \f$O(log(N))\f$ if they cannot merge, \f$O(N)\f$ if they can merge
+	 * Complexity \f$O(1)\f$, \f$O(N)\f$ if they can merge and are wide
 	 **/
 	region region::merge(const region& arg) const {
 		region ret;
 		if (samearea(arg)) {
-			ret._cells = _cells;
+			ret = *this;
 			ret._max = std::min(_max, arg._max);
 			ret._min = std::max(_min, arg._min);
 		}
@@ -199,16 +521,12 @@ namespace ms {
 	 * if bomb is not contained in the region, do nothing and return 1
 	 * if bomb is located in the region, but the region has no bombs throw bad_region_error, but still remove
 	 * 
-	 * Complexity \f$O(log(N))\f$
+	 * Complexity \f$O(1)\f$, \f$O(log(N))\f$ for wide regions
 	 **/
 	int region::remove_bomb(rc_coord bomb) {
-		iterator i = _cells.find(bomb);
-		if(i == _cells.end()) {
+		if(!erase_cell(bomb)) {
 			return 1;
 		} else {
-			assert(*i == bomb);
-			_cells.erase(i);
-
 				if(_min != 0)
 					--_min;
 				if(_max != 0)
@@ -222,20 +540,16 @@ namespace ms {
 
 	/**
 	 * removes a cell at the specified location treating it as a non bomb
-	 * removes from _cells, and returns 0
+	 * removes from the region, and returns 0
 	 * if safe is not contained in the region, do nothing and return 1
 	 * if safe is located in the region, but there are no safe spaces (min == size), remove the cell but throw bad_region_error
 	 * 
-	 * Complexity \f$O(log(N))\f$
+	 * Complexity \f$O(1)\f$, \f$O(log(N))\f$ for wide regions
 	 **/
 	int region::remove_safe(rc_coord safe) {
-		iterator i = _cells.find(safe);
-		if(i == _cells.end()) {
+		if(!erase_cell(safe)) {
 			return 1;
 		} else {
-			assert(*i == safe);
-			_cells.erase(i);
-
 			if(_max > size())
 				_max = size();
 			if(_min > _max) { //implies _min > size()
@@ -249,10 +563,14 @@ namespace ms {
 	/**
 	 * Returns true if the regions contain all of the same cells. 
 	 * 
-	 * Complexity \f$O(N)\f$.
+	 * Complexity \f$O(1)\f$, \f$O(N)\f$ for wide regions.
 	 **/
 	bool region::samearea(const region& comp) const { 
-		return _cells == comp._cells;
+		if(_is_wide != comp._is_wide)
+			return false;
+		if(_is_wide)
+			return _wide == comp._wide;
+		return _mask == comp._mask && _anchor == comp._anchor;
 	}
 
 	/**
@@ -260,11 +578,13 @@ namespace ms {
 	 * faster than region::intersect, so if you actually intend to use the intersection
 	 * it is probably better to take it directly.
 	 * 
-	 * Complexity \f$O(M \cdot log(N))\f$, where M is the size of `arg` and N is the size of `this`.
+	 * Complexity \f$O(1)\f$, \f$O(M \cdot log(N))\f$ if either region is wide, where M is the size of `arg` and N is the size of `this`.
 	 **/
 	bool region::has_intersect(const region& arg) const {
-		for (iterator it = arg.begin(); it != arg.end(); ++it) {
-			if(find(*it) != end())
+		if(!_is_wide && !arg._is_wide)
+			return (_mask & aligned(arg)) != 0;
+		for (rc_coord cell : arg) {
+			if(contains(cell))
 				return 1;
 		}
 
@@ -4,6 +4,8 @@
 #include <vector>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <set>
 #include <iostream>
 #include "rc_coord.h"
@@ -13,38 +15,99 @@
 namespace ms {
 
 	class region_set;
-	struct region_cmp_no_min_max;
 
 	class bad_region_error : public std::logic_error { using std::logic_error::logic_error; };
 
+	/**
+	 * The size and range of bombs of a region that has not been built. Used to decide
+	 * whether a region is worth building before paying for it.
+	 **/
+	struct region_bounds {
+		unsigned size, min, max;
+
+		/**Same as `region::is_reasonable` for the region these bounds describe.**/
+		bool is_reasonable() const { return min <= max && max <= size; }
+		/**Same as `region::is_helpful` for the region these bounds describe.**/
+		bool is_helpful() const { return !(size == max && min == 0); }
+	};
+
+	/**
+	 * Bounds of the three regions that can be derived from a pair of overlapping regions `a` and `b`.
+	 * See `region::split`.
+	 **/
+	struct region_split {
+		/**bounds of `a.intersect(b)`**/
+		region_bounds common;
+		/**bounds of `a.subtract(b)`**/
+		region_bounds this_only;
+		/**bounds of `b.subtract(a)`**/
+		region_bounds arg_only;
+	};
+
+	/**
+	 * A set of cells together with the range of bombs they may contain.
+	 *
+	 * Cells are stored as a 64 bit mask over an 8x8 window whose top left corner (`_anchor`)
+	 * is the smallest row and the smallest column of any cell in the region. Every region built
+	 * from the neighborhood of a cell fits in the window, so set operations between them are a
+	 * few shifts, ANDs and popcounts. Regions whose cells do not fit in the window fall back
+	 * to a `std::set<rc_coord>`.
+	 *
+	 * The representation is canonical: two regions with the same cells always have the same
+	 * mode, anchor and mask (or set), so comparing or hashing areas only looks at those members.
+	 **/
 	struct region {
 	private:
 		friend region_set;
-		friend region_cmp_no_min_max;
 
-		std::set<rc_coord> _cells;
-		mutable unsigned int _max, _min;
+		/**width and height of the window covered by `_mask`**/
+		static constexpr unsigned WINDOW = 8;
+
+		/**bit `(row - _anchor.row) * WINDOW + (col - _anchor.col)` is set for each cell in the region. Unused when `_is_wide`**/
+		std::uint64_t _mask;
+		/**smallest row and smallest column of the cells in the region, `(0,0)` if empty. Unused when `_is_wide`**/
+		rc_coord _anchor;
+		/**cells of regions that do not fit in the window. Empty unless `_is_wide`**/
+		std::set<rc_coord> _wide;
+		/**XOR of `cell_key` over `_wide`, updated as cells are added and removed. Zero unless `_is_wide`**/
+		std::uint64_t _wide_hash;
+		bool _is_wide;
+		unsigned int _max, _min;
+
+		static std::uint64_t cols_below(unsigned n);
+		static std::uint64_t fold_columns(std::uint64_t mask);
+		static std::uint64_t shift_window(std::uint64_t mask, long long dr, long long dc);
+		std::uint64_t aligned(const region& arg) const;
+		bool window_index(rc_coord rc, unsigned& index) const;
+		void normalize();
+		void make_wide();
+		void try_make_narrow();
+		int erase_cell(rc_coord rc);
+		static std::uint64_t mix(std::uint64_t x);
+		static std::uint64_t cell_key(rc_coord rc);
+		static region_bounds intersect_bounds(const region& a, const region& b, unsigned common);
+		static region_bounds subtract_bounds(const region& a, const region& b, unsigned common);
 	public:
 		/**The maximum number of bombs that could possibly be in the region.\n Complexity \f$O(1)\f$**/
 		unsigned int max() const { return _max; }
 		/**The minimum number of bombs that could possibly be in the region.\n Complexity \f$O(1)\f$**/
 		unsigned int min() const { return _min; }
 		/**Set the max and the min. Will fail if attempting to set an impossible value (min > max or max > size) and throw a bad_region_error. Otherwise returns 0.\n Complexity \f$O(1)\f$*/
-		int set_range(unsigned int min, unsigned int max) { if(min > max || max > _cells.size()) throw bad_region_error("impossible range"); _min = min; _max = max; return 0; }
+		int set_range(unsigned int min, unsigned int max) { if(min > max || max > size()) throw bad_region_error("impossible range"); _min = min; _max = max; return 0; }
 		/**Set the max and min to the same value. Will fail if attempting to set an impossible value and throw a bad_region_error. Otherwise returns 0.\n Complexity \f$O(1)\f$**/
-		int set_count(unsigned int minmax) { if(minmax > _cells.size()) throw bad_region_error("count greater than size"); _min = _max = minmax; return 0; }
+		int set_count(unsigned int minmax) { if(minmax > size()) throw bad_region_error("count greater than size"); _min = _max = minmax; return 0; }
 
 		/**Default constructor. Contains 0 cells. `max = min = 0`.\n Complexity \f$O(1)\f$. **/
-		region() { set_count(0); }
-		/**Copy constructor.\n Complexity \f$O(N)\f$. **/
-		region(const region& copy) { _cells = copy._cells; _max = copy._max; _min = copy._min; }
+		region() : _mask(0), _anchor(), _wide_hash(0), _is_wide(false) { set_count(0); }
+		/**Copy constructor.\n Complexity \f$O(1)\f$, \f$O(N)\f$ for wide regions. **/
+		region(const region& copy) = default;
 		/**Move constructor. \n Complexity \f$O(1)\f$. **/
-		region(region&& copy) { _cells = std::move(copy._cells); _max = copy._max; _min = copy._min; }
+		region(region&& copy) = default;
 
-		/**Copy assignment.\n Complexity \f$O(N)\f$. **/
-		region& operator=(const region& copy) { _cells = copy._cells; _max = copy._max; _min = copy._min; return *this; }
+		/**Copy assignment.\n Complexity \f$O(1)\f$, \f$O(N)\f$ for wide regions. **/
+		region& operator=(const region& copy) = default;
 		/**Move assignment. \n Complexity \f$O(1)\f$. **/
-		region& operator=(region&& copy) { _cells = std::move(copy._cells); _max = copy._max; _min = copy._min; return *this; }
+		region& operator=(region&& copy) = default;
 		
 
 		region intersect(const region& arg) const;
@@ -53,11 +116,13 @@ namespace ms {
 		region& subtract_to(const region& arg);
 		region merge(const region& arg) const;
 		region& merge_to(const region& arg);
+		unsigned count_common(const region& arg) const;
+		region_split split(const region& arg) const;
 
 		/**
 		 * Returns true if the cells are the same area and have the same `min` and `max`, false otherwise. 
 		 * 
-		 * Complexity \f$O(N^2)\f$.
+		 * Complexity \f$O(1)\f$, \f$O(N)\f$ for wide regions.
 		 **/
 		bool operator==(const region& comp) const { return samearea(comp) && _min == comp._min && _max == comp._max; }
 		/**Returns the opposite of `region::operator==`.**/
@@ -67,37 +132,77 @@ namespace ms {
 		}
 
 		bool samearea(const region& comp) const;
+		std::uint64_t hash() const;
 		bool has_intersect(const region& arg) const;
 		int add_cell(rc_coord rc);
 		int remove_bomb(rc_coord bomb);
 		int remove_safe(rc_coord safe);
 		/** returns true if the combination of max and min is possible with the current size**/
 		bool is_reasonable() const { return min() <= max() && max() <= size(); }
-		/**Returns the number of cells in the region.\n Complexity \f$O(1)\f$.**/
 		bool is_helpful() const;
-		size_t size() const { return _cells.size(); }
+		/**Returns the number of cells in the region.\n Complexity \f$O(1)\f$.**/
+		size_t size() const { return _is_wide ? _wide.size() : __builtin_popcountll(_mask); }
 		/**Returns true if the region has no cells, false otherwise.\n Complexity \f$O(1)\f$.**/
-		bool empty() const { return _cells.empty(); }
-		bool contains(rc_coord cell) const { return _cells.find(cell) != _cells.end(); }
-
-		typedef std::set<rc_coord>::iterator iterator;
-		typedef std::set<rc_coord>::const_iterator const_iterator;
-		iterator begin() { return _cells.begin(); }
-		iterator end() { return _cells.end(); }
-		const_iterator begin() const { return _cells.cbegin(); }
-		const_iterator end() const { return _cells.cend(); }
-		iterator find(const rc_coord& rc) { return _cells.find(rc); }
-		const_iterator find(const rc_coord& rc) const { return _cells.find(rc); }
+		bool empty() const { return _is_wide ? _wide.empty() : _mask == 0; }
+		/**Returns true if the region is stored as a `std::set` rather than a mask.\n Complexity \f$O(1)\f$.**/
+		bool is_wide() const { return _is_wide; }
+		bool contains(rc_coord cell) const;
+
+		/**
+		 * Iterates over the cells of a region in increasing order (by `rc_coord::operator<`).
+		 * Cells are returned by value.
+		 **/
+		class const_iterator {
+		public:
+			typedef std::input_iterator_tag iterator_category;
+			typedef rc_coord value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const rc_coord* pointer;
+			typedef rc_coord reference;
+
+			const_iterator() : _rest(0), _anchor(), _it(), _wide(false) { }
+
+			rc_coord operator*() const {
+				if(_wide)
+					return *_it;
+				unsigned index = __builtin_ctzll(_rest);
+				return rc_coord(_anchor.row + index / WINDOW, _anchor.col + index % WINDOW);
+			}
+			const_iterator& operator++() {
+				if(_wide)
+					++_it;
+				else
+					_rest &= _rest - 1;
+				return *this;
+			}
+			const_iterator operator++(int) { const_iterator ret = *this; ++*this; return ret; }
+			bool operator==(const const_iterator& comp) const { return _wide ? _it == comp._it : _rest == comp._rest; }
+			bool operator!=(const const_iterator& comp) const { return !(*this == comp); }
+		private:
+			friend region;
+			const_iterator(std::uint64_t rest, rc_coord anchor) : _rest(rest), _anchor(anchor), _it(), _wide(false) { }
+			const_iterator(std::set<rc_coord>::const_iterator it) : _rest(0), _anchor(), _it(it), _wide(true) { }
+
+			std::uint64_t _rest;
+			rc_coord _anchor;
+			std::set<rc_coord>::const_iterator _it;
+			bool _wide;
+		};
+		typedef const_iterator iterator;
+
+		const_iterator begin() const { return _is_wide ? const_iterator(_wide.cbegin()) : const_iterator(_mask, _anchor); }
+		const_iterator end() const { return _is_wide ? const_iterator(_wide.cend()) : const_iterator(0, _anchor); }
+		const_iterator find(const rc_coord& rc) const;
 
 		std::string to_string() const {
 			std::string ret;
 			ret += "{ [" + std::to_string(size()) + "|" + std::to_string(min()) + "-" + std::to_string(max()) + "] ";
-			if(!empty()) {
-				auto it = begin();
-				for(; std::next(it) != end(); ++it) {
-					ret += it->to_string() + ",";
-				}
-				ret += it->to_string();
+			bool first = true;
+			for(rc_coord cell : *this) {
+				if(!first)
+					ret += ",";
+				ret += cell.to_string();
+				first = false;
 			}
 			return ret + " }";
 
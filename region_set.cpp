@@ -1,4 +1,5 @@
 #include "region_set.h"
+#include <algorithm>
 
 namespace ms {
 
@@ -7,194 +8,600 @@ namespace ms {
  * 
  * attempting to add a region outside of these bounds is an error
  **/
-region_set::region_set(unsigned height, unsigned width) : keys(boost::extents[height][width]) {}
+region_set::region_set(unsigned height, unsigned width) :
+    keys(boost::extents[height][width]), key_epochs(boost::extents[height][width]) {
+    std::fill_n(key_epochs.data(), key_epochs.num_elements(), 0);
+}
 
 /**
- * copies a region_set, including contents, keys, and modified regions
+ * Returns the handle of the region covering the same area as `area`, or `NO_REGION`
+ * if there is none. Only the cells of `area` are compared, not `min` or `max`.
  * 
- * Complexity \f$O(N)\f$
+ * Complexity \f$O(1)\f$
+ **/
+region_set::handle region_set::find(const region& area) const {
+    if(by_area.empty())
+        return NO_REGION;
+    std::uint64_t hash = area.hash();
+    size_t mask = by_area.size() - 1;
+    for(size_t i = hash & mask; by_area[i].h != NO_REGION; i = (i + 1) & mask) {
+        if(by_area[i].hash == hash && slots[index_of(by_area[i].h)].reg.samearea(area))
+            return by_area[i].h;
+    }
+    return NO_REGION;
+}
+
+/**
+ * Inserts a region into the by-area hash table, growing the table if it would become more than half full.
+ *
+ * Complexity \f$O(1)\f$ amortized
  **/
-region_set::region_set(const region_set& copy) : keys(boost::extents[copy.keys.shape()[0]][copy.keys.shape()[1]]) {
-    contents = copy.contents;
-    for(iterator it = contents.begin(); it != contents.end(); ++it) {
-        for(rc_coord cell : *it) {
-            keys[cell.row][cell.col].insert(it);
+void region_set::index_area(handle h, std::uint64_t hash) {
+    log(trail_op::INDEX_AREA, h, hash);
+    insert_area(h, hash);
+}
+
+void region_set::insert_area(handle h, std::uint64_t hash) {
+    if(2 * (region_count + 1) > by_area.size()) {
+        std::vector<hash_entry> old(std::max<size_t>(16, 2 * by_area.size()), hash_entry{0, NO_REGION});
+        old.swap(by_area);
+        size_t mask = by_area.size() - 1;
+        for(const hash_entry& entry : old) {
+            if(entry.h == NO_REGION)
+                continue;
+            size_t i = entry.hash & mask;
+            while(by_area[i].h != NO_REGION)
+                i = (i + 1) & mask;
+            by_area[i] = entry;
         }
     }
-    const_iterator this_it = cbegin();
-    const_iterator copy_it = copy.cbegin();
-    assert(size() == copy.size());
-    //equivalent regions should be in the same order
-    for(; copy_it != copy.cend(); ++this_it, ++copy_it) {
-        if(copy.modified_regions.find(copy_it) != copy.modified_regions.cend()) { //if *copy_it was modified
-            modified_regions.insert(this_it);
+    size_t mask = by_area.size() - 1;
+    size_t i = hash & mask;
+    while(by_area[i].h != NO_REGION)
+        i = (i + 1) & mask;
+    by_area[i] = hash_entry{hash, h};
+    ++region_count;
+}
+
+/**
+ * Removes a region from the by-area hash table. `hash` must be the hash the region was indexed with.
+ * Later entries of the probe sequence are shifted back so that no tombstones are needed.
+ *
+ * Complexity \f$O(1)\f$ average
+ **/
+void region_set::unindex_area(handle h, std::uint64_t hash) {
+    log(trail_op::UNINDEX_AREA, h, hash);
+    erase_area(h, hash);
+}
+
+void region_set::erase_area(handle h, std::uint64_t hash) {
+    size_t mask = by_area.size() - 1;
+    size_t i = hash & mask;
+    while(by_area[i].h != h) {
+        assert(by_area[i].h != NO_REGION && "region is not in the by-area index");
+        i = (i + 1) & mask;
+    }
+    for(size_t j = (i + 1) & mask; by_area[j].h != NO_REGION; j = (j + 1) & mask) {
+        size_t home = by_area[j].hash & mask;
+        //move the entry at j into the hole unless its home lies cyclically in (i, j]
+        bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if(!stays) {
+            by_area[i] = by_area[j];
+            i = j;
         }
     }
-    assert(this_it == cend());
+    by_area[i].h = NO_REGION;
+    --region_count;
 }
 
 /**
  * Adds a region to the list of regions, merging if a region already exists covering the same area.
  * Skips regions that offer no information. If a new region is added, add it to the appropriate cell_keys
  * 
- * `first` is `regions.end()` if region not added, otherwise returns an iterator to the region added/merged. 
+ * `first` is `NO_REGION` if region not added, otherwise returns the handle of the region added/merged.
  * 
  * `second` is `true` if the contents were modified.
  * 
- * Complexity \f$O(N)\f$
+ * Complexity \f$O(M)\f$ where \f$M\f$ is the size of the region
  **/
-std::pair<region_set::iterator,bool> region_set::add(const region& to_add) {
+std::pair<region_set::handle,bool> region_set::add(const region& to_add) {
     if(!to_add.is_reasonable()) {
         throw bad_region_error("attempted to add invalid region: " + to_add.to_string());
     }
 
-    typedef std::pair<iterator, bool> ret_type;
+    typedef std::pair<handle, bool> ret_type;
 
     if(!to_add.is_helpful()) {
-        return ret_type(contents.end(), false);
+        return ret_type(NO_REGION, false);
     }
 
-    iterator added;
+    handle added = find(to_add);
     bool did_add = false;
-    iterator similar = contents.lower_bound(to_add);
 
-    if(!to_add.is_reasonable()) {
-        throw bad_region_error("adding region to region_set that fails is_reasonable(): " + to_add.to_string());
-    }
-
-    if(similar == contents.end() || !similar->samearea(to_add)) {
-        auto added_info = contents.insert(to_add);
-        assert(added_info.second);
-        added = added_info.first;
+    if(added == NO_REGION) {
+        std::uint32_t index = allocate_slot();
+        slot& s = touch(index);
+        s.reg = to_add;
+        s.live = true;
+        added = make_handle(index, s.generation);
+        index_area(added, to_add.hash());
         did_add = true;
         for(rc_coord cell : to_add) {
-            keys[cell.row][cell.col].insert(added);
+            touch_key(cell).push_back(added);
         }
     } else {
-        did_add = similar->min() < to_add.min() || similar->max() > to_add.max();
-        order_preserve_merge(similar, to_add);
-        added = similar;
+        const region& existing = (*this)[added];
+        did_add = existing.min() < to_add.min() || existing.max() > to_add.max();
+        order_preserve_merge(added, to_add);
     }
 
     if (did_add) {
-        modified_regions.insert(added);
+        mark_modified(added);
     }
 
-    if(!added->is_reasonable()) {
-        throw bad_region_error("adding region to region_set resulted in failing is_reasonable(): " + added->to_string());
+    if(!(*this)[added].is_reasonable()) {
+        throw bad_region_error("adding region to region_set resulted in failing is_reasonable(): " + (*this)[added].to_string());
     }
-    assert(added->is_reasonable());
     return ret_type(added, did_add);
 }
 
 /**
  * Removes the specified region from the list of regions and all associated keys.
  * 
- * Complexity \f$O(log(N) + M)\f$ where \f$M\f$ is the size of the region and 
- * \f$N\f$ is the number of regions
+ * Complexity \f$O(M \cdot K)\f$ where \f$M\f$ is the size of the region and \f$K\f$
+ * is the number of regions at each cell
+ **/
+void region_set::remove(handle to_remove) {
+    unindex_area(to_remove, (*this)[to_remove].hash());
+    release(to_remove);
+}
+
+/**
+ * Removes a region that is not in the by-area index from its keys and the modified
+ * regions, and frees its slot.
+ *
+ * Complexity \f$O(M \cdot K)\f$ where \f$M\f$ is the size of the region and \f$K\f$
+ * is the number of regions at each cell
  **/
-region_set::iterator region_set::remove(iterator to_remove) {
-    for(rc_coord cell : *to_remove) {
-        key_type& key = keys[cell.row][cell.col];
-        key_type::iterator remove_it = key.find(to_remove);
+void region_set::release(handle to_remove) {
+    for(rc_coord cell : (*this)[to_remove]) {
+        key_type& key = touch_key(cell);
+        key_type::iterator remove_it = std::find(key.begin(), key.end(), to_remove);
         assert(remove_it != key.end());
-        key.erase(remove_it);
+        *remove_it = key.back();
+        key.pop_back();
     }
-    modified_regions.erase(to_remove);
-    return contents.erase(to_remove);
+    unmark_modified(to_remove);
+
+    slot& s = touch(index_of(to_remove));
+    s.reg = region();
+    s.live = false;
+    s.determined = false;
+    ++s.generation;
+    free_slot(index_of(to_remove));
 }
 
+/**
+ * Removes all regions. Handles to any of them become invalid.
+ *
+ * Complexity \f$O(M)\f$ where \f$M\f$ is the total size of all regions
+ **/
 void region_set::clear() {
-    for(unsigned r = 0; r < keys.shape()[0]; ++r) {
-        for(unsigned c = 0; c < keys.shape()[1]; ++c) {
-            keys[r][c].clear();
+    if(!checkpoints.empty()) {
+        //remove the regions one by one so that they are recorded
+        for(const_iterator it = begin(); it != end(); ++it) {
+            remove(it.get_handle());
+        }
+        modified_regions.clear();
+        determined_regions.clear();
+        return;
+    }
+    for(std::uint32_t index = 0; index < slots.size(); ++index) {
+        slot& s = slots[index];
+        if(!s.live)
+            continue;
+        for(rc_coord cell : s.reg) {
+            keys[cell.row][cell.col].clear();
         }
+        s.reg = region();
+        s.live = false;
+        s.modified_pos = NOT_MODIFIED;
+        s.determined = false;
+        ++s.generation;
+        free_slots.push_back(index);
     }
-    contents.clear();
+    by_area.clear();
+    region_count = 0;
     modified_regions.clear();
+    determined_regions.clear();
 }
 
 const region_set::subset_type& region_set::get_modified_regions() const {
     return modified_regions;
 }
 void region_set::reset_modified_regions() {
+    for(handle h : modified_regions) {
+        touch(index_of(h)).modified_pos = NOT_MODIFIED;
+    }
     modified_regions.clear();
 }
 
+/**
+ * Returns the regions that became determined (`size() == min()` or `max() == 0`) since the last call
+ * to `reset_determined_regions`, in the order they became determined. A region stays determined
+ * as long as it is in the set, so each region is reported at most once. Handles of regions removed
+ * since they were reported are left in the list, check them with `is_valid`.
+ **/
+const region_set::subset_type& region_set::get_determined_regions() const {
+    return determined_regions;
+}
+void region_set::reset_determined_regions() {
+    determined_regions.clear();
+}
+
+/**
+ * Adds a region to the list of modified regions if it is not there already,
+ * and to the list of determined regions if it has just become determined.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+void region_set::mark_modified(handle h) {
+    const slot& current = slots[index_of(h)];
+    bool determined = !current.determined && (current.reg.size() == current.reg.min() || current.reg.max() == 0);
+    if(!determined && current.modified_pos != NOT_MODIFIED)
+        return;
+    slot& s = touch(index_of(h));
+    if(determined) {
+        s.determined = true;
+        determined_regions.push_back(h);
+    }
+    if(s.modified_pos == NOT_MODIFIED) {
+        s.modified_pos = modified_regions.size();
+        modified_regions.push_back(h);
+    }
+}
+
+/**
+ * Removes a region from the list of modified regions if it is there
+ *
+ * Complexity \f$O(1)\f$
+ **/
+void region_set::unmark_modified(handle h) {
+    if(slots[index_of(h)].modified_pos != NOT_MODIFIED) {
+        slot& s = touch(index_of(h));
+        handle moved = modified_regions.back();
+        modified_regions[s.modified_pos] = moved;
+        touch(index_of(moved)).modified_pos = s.modified_pos;
+        modified_regions.pop_back();
+        s.modified_pos = NOT_MODIFIED;
+    }
+}
+
 /**
  * returns a container of type `subset_type` containing all regions that intersect 
  * the input region.
  * 
- * Complexity \f$O(M \cdot N)\f$ where \f$M\f$ is the size of 
- * the input region and \f$N\f$ is the number of regions.
+ * Complexity \f$O(K \cdot log(K))\f$ where \f$K\f$ is the total number of keys of the cells
+ * in the input region.
  **/
 region_set::subset_type region_set::regions_intersecting(const region& arg) const {
     subset_type ret;
+    regions_intersecting(arg, ret);
+    return ret;
+}
+
+/**
+ * Same as `regions_intersecting(const region&)`, but writes the regions into `out` (after clearing it)
+ * so that a caller can reuse the same buffer without allocating.
+ *
+ * Complexity \f$O(K \cdot log(K))\f$ where \f$K\f$ is the total number of keys of the cells
+ * in the input region.
+ **/
+void region_set::regions_intersecting(const region& arg, subset_type& out) const {
+    out.clear();
     for(rc_coord cell : arg) {
         const key_type& key = keys[cell.row][cell.col];
-        for(const iterator& elem : key) {
-            ret.insert(elem);
-        }
+        out.insert(out.end(), key.begin(), key.end());
     }
-    return ret;
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
 }
+
 const region_set::subset_type& region_set::regions_intersecting(rc_coord cell) const {
     return keys[cell.row][cell.col];
 }
 
+/**
+ * To be called when a cell is opened. Removes the cell from every region containing it.
+ *
+ * Returns the number of regions that contained the cell.
+ *
+ * Complexity \f$O(K)\f$ where \f$K\f$ is the number of regions containing the cell
+ **/
 int region_set::remove_safe(rc_coord cell) {
-    int removed = 0;
-    std::vector<region> replacements;
-    key_type& key = keys[cell.row][cell.col];
-    while(!key.empty()) {
-        key_type::iterator it = key.begin();
-        region replace = **it;
+    return remove_cell(cell, false);
+}
+
+/**
+ * To be called when a cell is flagged. Removes the cell from every region containing it,
+ * lowering their bomb counts.
+ *
+ * Returns the number of regions that contained the cell.
+ *
+ * Complexity \f$O(K)\f$ where \f$K\f$ is the number of regions containing the cell
+ **/
+int region_set::remove_bomb(rc_coord cell) {
+    return remove_cell(cell, true);
+}
+
+/**
+ * To be called when many cells are resolved at once, such as when opening a cell opens a whole
+ * area of zeroes. Removes every cell in `safe` as in `remove_safe` and every cell in `bombs` as in
+ * `remove_bomb`, but each region containing any of the cells is taken out of the by-area index,
+ * merged with a colliding region and marked as modified only once.
+ *
+ * Returns the number of regions that contained at least one of the cells.
+ *
+ * If a region cannot lose one of its cells it is removed. All other regions are still updated,
+ * and bad_region_error is thrown once all cells have been removed.
+ *
+ * Complexity \f$O(K \cdot log(K))\f$ where \f$K\f$ is the total number of keys of the cells
+ **/
+int region_set::resolve_cells(const std::vector<rc_coord>& safe, const std::vector<rc_coord>& bombs) {
+    subset_type touched;
+    for(const std::vector<rc_coord>* cells : { &safe, &bombs }) {
+        for(rc_coord cell : *cells) {
+            const key_type& key = keys[cell.row][cell.col];
+            touched.insert(touched.end(), key.begin(), key.end());
+        }
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for(handle h : touched) {
+        unindex_area(h, (*this)[h].hash());
+    }
+
+    subset_type failed;
+    std::string error;
+    for(const std::vector<rc_coord>* cells : { &safe, &bombs }) {
+        bool bomb = cells == &bombs;
+        for(rc_coord cell : *cells) {
+            key_type& key = touch_key(cell);
+            for(handle h : key) {
+                try {
+                    if(bomb)
+                        get(h).remove_bomb(cell);
+                    else
+                        get(h).remove_safe(cell);
+                } catch (const bad_region_error& e) {
+                    failed.push_back(h);
+                    if(error.empty())
+                        error = bomb ? "could not remove bomb cell from region_set" :
+                            "could not remove safe cell " + cell.to_string() + " from region_set";
+                }
+            }
+            key.clear();
+        }
+    }
+    std::sort(failed.begin(), failed.end());
+
+    for(handle h : touched) {
+        if(std::binary_search(failed.begin(), failed.end(), h)) {
+            release(h);
+            continue;
+        }
         try {
-            replace.remove_safe(cell);
+            reindex(h);
         } catch (const bad_region_error& e) {
-            throw bad_region_error("could not remove safe cell " + cell.to_string() + " from region_set");
+            if(error.empty())
+                error = e.what();
         }
-        replacements.push_back(std::move(replace));
-        remove(*it);
-        ++removed;
     }
-    for(region& to_add : replacements) {
-        add(std::move(to_add));
+
+    if(!error.empty()) {
+        throw bad_region_error(error);
     }
-    return removed;
+    return touched.size();
 }
 
-int region_set::remove_bomb(rc_coord cell) {
+/**
+ * Removes a resolved cell from every region containing it. Regions are changed in place, so
+ * their keys at other cells stay as they are. A region is only merged away if it ends up with
+ * the same area as another region, and dropped if it is no longer helpful.
+ *
+ * If a region cannot lose the cell (see `region::remove_safe`, `region::remove_bomb`) that region is
+ * removed and bad_region_error is thrown. The regions that were not reached yet are left untouched.
+ *
+ * Complexity \f$O(K)\f$ where \f$K\f$ is the number of regions containing the cell
+ **/
+int region_set::remove_cell(rc_coord cell, bool bomb) {
     int removed = 0;
-    std::vector<region> replacements;
-    key_type& key = keys[cell.row][cell.col];
+    key_type& key = touch_key(cell);
     while(!key.empty()) {
-        key_type::iterator it = key.begin();
-        region replace = **it;
+        handle h = key.back();
+        key.pop_back();
+        region& reg = get(h);
+        unindex_area(h, reg.hash());
         try {
-            replace.remove_bomb(cell);
+            if(bomb)
+                reg.remove_bomb(cell);
+            else
+                reg.remove_safe(cell);
         } catch (const bad_region_error& e) {
-            throw bad_region_error("could not remove bomb cell from region_set");
+            release(h);
+            if(bomb)
+                throw bad_region_error("could not remove bomb cell from region_set");
+            else
+                throw bad_region_error("could not remove safe cell " + cell.to_string() + " from region_set");
         }
-
-        replacements.push_back(std::move(replace));
-        remove(*it);
+        reindex(h);
         ++removed;
     }
-    for(region& to_add : replacements) {
-        add(std::move(to_add));
-    }
     return removed;
 }
 
-void region_set::order_preserve_merge(set_type::iterator to_change, const region& to_add) {
-    assert(to_change->samearea(to_add));
-    if(to_add._min > to_change->_min)
-        to_change->_min = to_add._min;
-    if(to_add._max < to_change->_max)
-        to_change->_max = to_add._max;
+/**
+ * Puts a region that was changed in place (and removed from the by-area index) back in the index.
+ * If another region already covers the same area the two are merged and `h` is released.
+ * Unhelpful regions are released. Throws bad_region_error if the merged region fails is_reasonable().
+ *
+ * Complexity \f$O(1)\f$, or \f$O(M \cdot K)\f$ if the region is released
+ **/
+void region_set::reindex(handle h) {
+    const region& reg = (*this)[h];
+    if(!reg.is_helpful()) {
+        release(h);
+        return;
+    }
+    handle existing = find(reg);
+    if(existing == NO_REGION) {
+        index_area(h, reg.hash());
+        mark_modified(h);
+        return;
+    }
+    const region& kept = (*this)[existing];
+    if(kept.min() < reg.min() || kept.max() > reg.max()) {
+        order_preserve_merge(existing, reg);
+        mark_modified(existing);
+    }
+    release(h);
+    if(!kept.is_reasonable()) {
+        throw bad_region_error("merging changed region resulted in failing is_reasonable(): " + kept.to_string());
+    }
+}
+
+/**
+ * Starts recording every change to the set so that it can be undone by `rollback`. Checkpoints
+ * nest: each `rollback` undoes the changes since the most recent checkpoint.
+ *
+ * Each slot and each cell key is saved the first time it changes after the checkpoint, and
+ * changes to the by-area index and the free slots are recorded as operations to be reversed.
+ * The modified and determined regions are saved as a whole, they are usually short.
+ *
+ * Complexity \f$O(D)\f$ where \f$D\f$ is the number of modified and determined regions
+ **/
+void region_set::checkpoint() {
+    checkpoints.push_back(checkpoint_state{ slot_trail.size(), key_trail.size(), op_trail.size(), epoch,
+        modified_regions, determined_regions });
+    epoch = next_epoch++;
+}
+
+/**
+ * Undoes every change since the most recent checkpoint, and removes the checkpoint.
+ * Handles that were valid at the checkpoint are valid again and refer to the same regions.
+ *
+ * Complexity \f$O(M)\f$ where \f$M\f$ is the number of slots, keys and index entries changed since the checkpoint
+ **/
+void region_set::rollback() {
+    assert(!checkpoints.empty());
+    checkpoint_state& state = checkpoints.back();
+    while(slot_trail.size() > state.slot_trail_size) {
+        slots[slot_trail.back().first] = std::move(slot_trail.back().second);
+        slot_trail.pop_back();
+    }
+    while(key_trail.size() > state.key_trail_size) {
+        key_save& saved = key_trail.back();
+        keys[saved.cell.row][saved.cell.col] = std::move(saved.key);
+        key_epochs[saved.cell.row][saved.cell.col] = saved.epoch;
+        key_trail.pop_back();
+    }
+    while(op_trail.size() > state.op_trail_size) {
+        const trail_op& op = op_trail.back();
+        switch(op.kind) {
+        case trail_op::INDEX_AREA:
+            erase_area(op.value, op.hash);
+            break;
+        case trail_op::UNINDEX_AREA:
+            insert_area(op.value, op.hash);
+            break;
+        case trail_op::PUSH_FREE:
+            assert(free_slots.back() == op.value);
+            free_slots.pop_back();
+            break;
+        case trail_op::POP_FREE:
+            free_slots.push_back(op.value);
+            break;
+        case trail_op::APPEND_SLOT:
+            assert(slots.size() == op.value + 1);
+            slots.pop_back();
+            break;
+        }
+        op_trail.pop_back();
+    }
+    modified_regions = std::move(state.modified_regions);
+    determined_regions = std::move(state.determined_regions);
+    epoch = state.epoch;
+    checkpoints.pop_back();
 }
 
+/**
+ * Returns a slot that is about to be changed, saving it first if a checkpoint is active and it
+ * was not saved since the checkpoint.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+region_set::slot& region_set::touch(std::uint32_t index) {
+    slot& s = slots[index];
+    if(!checkpoints.empty() && s.epoch != epoch) {
+        slot_trail.emplace_back(index, s);
+        s.epoch = epoch;
+    }
+    return s;
+}
 
+/**
+ * Returns the key of a cell that is about to be changed, saving it first if a checkpoint is
+ * active and it was not saved since the checkpoint.
+ *
+ * Complexity \f$O(1)\f$, \f$O(K)\f$ when saved
+ **/
+region_set::key_type& region_set::touch_key(rc_coord cell) {
+    std::uint32_t& key_epoch = key_epochs[cell.row][cell.col];
+    key_type& key = keys[cell.row][cell.col];
+    if(!checkpoints.empty() && key_epoch != epoch) {
+        key_trail.push_back(key_save{ cell, key_epoch, key });
+        key_epoch = epoch;
+    }
+    return key;
+}
+
+void region_set::log(trail_op::kind_type kind, std::uint32_t value, std::uint64_t hash) {
+    if(!checkpoints.empty())
+        op_trail.push_back(trail_op{ kind, value, hash });
 }
 
+/**
+ * Returns the index of an unused slot, reusing a freed one if there is one.
+ **/
+std::uint32_t region_set::allocate_slot() {
+    std::uint32_t index;
+    if(free_slots.empty()) {
+        index = slots.size();
+        assert(index < INDEX_MASK && "too many regions for a region_set handle");
+        slots.emplace_back();
+        log(trail_op::APPEND_SLOT, index);
+    } else {
+        index = free_slots.back();
+        free_slots.pop_back();
+        log(trail_op::POP_FREE, index);
+    }
+    return index;
+}
+
+void region_set::free_slot(std::uint32_t index) {
+    free_slots.push_back(index);
+    log(trail_op::PUSH_FREE, index);
+}
+
+void region_set::order_preserve_merge(handle to_change, const region& to_add) {
+    region& existing = get(to_change);
+    assert(existing.samearea(to_add));
+    if(to_add._min > existing._min)
+        existing._min = to_add._min;
+    if(to_add._max < existing._max)
+        existing._max = to_add._max;
+}
+
+
+}
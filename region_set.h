@@ -3,87 +3,191 @@
 
 
 #include "region.h"
-#include <set>
-#include <unordered_set>
+#include <cstdint>
+#include <iterator>
+#include <vector>
 #include <boost/multi_array.hpp>
 
 namespace ms {
 
 /**
- * lexicographically compare cells in a region
+ * A collection of regions, where no two regions cover the same area.
  * 
- * \note only cells are compared, not min or max. thus, if `a.samearea(b)` then 
- * `!(a < b || b < a)` and they are equivalent in a set. this is a desirable characteristic
- * because it allows easy searching, but must be careful when adding to a set that you don't
- * "lose" your region
+ * Regions are stored in a contiguous slot map and referred to by `handle`s: 32 bit integers
+ * holding the index of the slot and the generation of the slot, which changes each time the
+ * slot is reused so that handles of removed regions can be detected. Every index (the regions
+ * at each cell, the modified regions, and the regions by area) is a plain array of handles,
+ * so copying a region_set is a handful of vector copies.
+ *
+ * Regions covering the same area are found through an open addressing hash table keyed
+ * on `region::hash`, so adding a region costs a single probe.
+ *
+ * Regions that become determined (all of their cells are bombs, or all are safe) are reported
+ * in `get_determined_regions` as soon as they are added or changed, so they never have to be
+ * searched for.
  **/
-struct region_cmp_no_min_max {
-    bool operator()(const region& arg1, const region& arg2) {
-		return arg1._cells < arg2._cells;
-    }
-};
-
-/**
- * hash based on the underlying pointer
- **/
-struct region_iter_hash {
-    std::size_t operator()(const std::set<region, region_cmp_no_min_max>::const_iterator& arg) const {
-        std::hash<const region*> my_hash;
-        return my_hash(&(*arg));
-    }
-    std::size_t operator()(const std::set<region, region_cmp_no_min_max>::const_reverse_iterator& arg) const {
-        std::hash<const region*> my_hash;
-        return my_hash(&(*arg));
-    }
-};
-
 class region_set {
-public:
-    typedef std::set<region, region_cmp_no_min_max> set_type;
-
-    typedef set_type::iterator iterator;
-    typedef set_type::const_iterator const_iterator;
-    typedef set_type::reverse_iterator reverse_iterator;
-    typedef set_type::const_reverse_iterator const_reverse_iterator;
+private:
+    static constexpr unsigned INDEX_BITS = 24;
+    static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr std::uint32_t NOT_MODIFIED = 0xffffffff;
+
+    struct slot {
+        region reg;
+        /**incremented each time the slot is freed, stored in the high 8 bits of a handle**/
+        std::uint8_t generation = 0;
+        /**position of the handle in `modified_regions`, or `NOT_MODIFIED`**/
+        std::uint32_t modified_pos = NOT_MODIFIED;
+        /**set once the region has been put in `determined_regions`**/
+        bool determined = false;
+        bool live = false;
+        /**the checkpoint epoch in which the slot was last saved to `slot_trail`**/
+        std::uint32_t epoch = 0;
+    };
+
+    /**entry of the by-area hash table, empty when `h == NO_REGION`**/
+    struct hash_entry {
+        std::uint64_t hash;
+        std::uint32_t h;
+    };
+
+    /**a change recorded while a checkpoint is active that is undone by an inverse operation**/
+    struct trail_op {
+        enum kind_type : std::uint8_t { INDEX_AREA, UNINDEX_AREA, PUSH_FREE, POP_FREE, APPEND_SLOT } kind;
+        /**the handle for `INDEX_AREA` and `UNINDEX_AREA`, the slot index for `PUSH_FREE` and `POP_FREE`**/
+        std::uint32_t value;
+        std::uint64_t hash;
+    };
+    /**the key of a cell before its first change since the checkpoint**/
+    struct key_save {
+        rc_coord cell;
+        std::uint32_t epoch;
+        std::vector<std::uint32_t> key;
+    };
+    /**state restored by `rollback` that is not kept in the trails**/
+    struct checkpoint_state {
+        size_t slot_trail_size, key_trail_size, op_trail_size;
+        std::uint32_t epoch;
+        std::vector<std::uint32_t> modified_regions, determined_regions;
+    };
 
-    typedef std::unordered_set<iterator, region_iter_hash> subset_type;
+public:
+    typedef std::uint32_t handle;
+    typedef std::vector<handle> subset_type;
     typedef subset_type key_type;
 
+    /**returned in place of a handle when no region is referred to**/
+    static constexpr handle NO_REGION = 0xffffffff;
+
+    /**
+     * Iterates over all regions in the set. Dereferences to the region, the handle
+     * of the region is available through `get_handle`.
+     **/
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef region value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const region* pointer;
+        typedef const region& reference;
+
+        const region& operator*() const { return (*_slots)[_index].reg; }
+        const region* operator->() const { return &(*_slots)[_index].reg; }
+        const_iterator& operator++() { ++_index; skip_dead(); return *this; }
+        const_iterator operator++(int) { const_iterator ret = *this; ++*this; return ret; }
+        bool operator==(const const_iterator& comp) const { return _index == comp._index; }
+        bool operator!=(const const_iterator& comp) const { return _index != comp._index; }
+        handle get_handle() const { return make_handle(_index, (*_slots)[_index].generation); }
+    private:
+        friend region_set;
+        const_iterator(const std::vector<slot>* slots, std::uint32_t index) : _slots(slots), _index(index) { skip_dead(); }
+        void skip_dead() { while(_index < _slots->size() && !(*_slots)[_index].live) ++_index; }
+
+        const std::vector<slot>* _slots;
+        std::uint32_t _index;
+    };
 
     region_set(unsigned height, unsigned width);
-    region_set(const region_set& copy);
 
-    std::pair<iterator,bool> add(const region&);
-    iterator remove(iterator);
+    std::pair<handle,bool> add(const region&);
+    void remove(handle);
     void clear();
+    handle find(const region& area) const;
+
+    /**Returns the region referred to by a handle. The handle must be valid (see `is_valid`).\n Complexity \f$O(1)\f$**/
+    const region& operator[](handle h) const { assert(is_valid(h)); return slots[index_of(h)].reg; }
+    /**Returns true if the handle refers to a region currently in the set.\n Complexity \f$O(1)\f$**/
+    bool is_valid(handle h) const {
+        return h != NO_REGION && index_of(h) < slots.size() && slots[index_of(h)].live && slots[index_of(h)].generation == generation_of(h);
+    }
+    /**Returns true if the region was modified since the last call to `reset_modified_regions`.\n Complexity \f$O(1)\f$**/
+    bool is_modified(handle h) const { return slots[index_of(h)].modified_pos != NOT_MODIFIED; }
 
     const subset_type& get_modified_regions() const;
     void reset_modified_regions();
+    void mark_modified(handle);
+    const subset_type& get_determined_regions() const;
+    void reset_determined_regions();
 
     subset_type regions_intersecting(const region&) const;
+    void regions_intersecting(const region&, subset_type& out) const;
     const subset_type& regions_intersecting(rc_coord) const;
 
+    void checkpoint();
+    void rollback();
+    /**Returns the number of checkpoints that have not been rolled back.\n Complexity \f$O(1)\f$**/
+    size_t checkpoint_depth() const { return checkpoints.size(); }
+
     int remove_safe(rc_coord);
     int remove_bomb(rc_coord);
+    int resolve_cells(const std::vector<rc_coord>& safe, const std::vector<rc_coord>& bombs);
     
-    size_t size() const { return contents.size(); }
-    bool empty() const { return contents.empty(); }
-    iterator begin() { return contents.begin(); }
-    iterator end() { return contents.end(); }
-    const_iterator cbegin() const { return contents.cbegin(); }
-    const_iterator cend() const { return contents.cend(); }
-    reverse_iterator rbegin() { return contents.rbegin(); }
-    reverse_iterator rend() { return contents.rend(); }
-    const_reverse_iterator crbegin() const { return contents.crbegin(); }
-    const_reverse_iterator crend() const { return contents.crend(); }
+    size_t size() const { return region_count; }
+    bool empty() const { return region_count == 0; }
+    const_iterator begin() const { return const_iterator(&slots, 0); }
+    const_iterator end() const { return const_iterator(&slots, slots.size()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
 
 private:
-
-    set_type contents;
+    static handle make_handle(std::uint32_t index, std::uint8_t generation) { return (std::uint32_t(generation) << INDEX_BITS) | index; }
+    static std::uint32_t index_of(handle h) { return h & INDEX_MASK; }
+    static std::uint32_t generation_of(handle h) { return h >> INDEX_BITS; }
+
+    std::vector<slot> slots;
+    std::vector<std::uint32_t> free_slots;
+    /**hash table of all regions by area. Its size is zero or a power of two, and at most half full**/
+    std::vector<hash_entry> by_area;
+    size_t region_count = 0;
     subset_type modified_regions;    
+    subset_type determined_regions;
     boost::multi_array<key_type, 2> keys;
 
-    void order_preserve_merge(set_type::iterator, const region&);
+    //undo information, only recorded while a checkpoint is active
+    std::vector<checkpoint_state> checkpoints;
+    std::vector<std::pair<std::uint32_t, slot>> slot_trail;
+    std::vector<key_save> key_trail;
+    std::vector<trail_op> op_trail;
+    boost::multi_array<std::uint32_t, 2> key_epochs;
+    /**the epoch of the active checkpoint, each checkpoint gets a new one**/
+    std::uint32_t epoch = 0;
+    std::uint32_t next_epoch = 1;
+
+    region& get(handle h) { assert(is_valid(h)); return touch(index_of(h)).reg; }
+    slot& touch(std::uint32_t index);
+    key_type& touch_key(rc_coord cell);
+    void log(trail_op::kind_type kind, std::uint32_t value, std::uint64_t hash = 0);
+    std::uint32_t allocate_slot();
+    void free_slot(std::uint32_t index);
+    void insert_area(handle, std::uint64_t hash);
+    void erase_area(handle, std::uint64_t hash);
+    void release(handle);
+    int remove_cell(rc_coord, bool bomb);
+    void reindex(handle);
+    void index_area(handle, std::uint64_t hash);
+    void unindex_area(handle, std::uint64_t hash);
+    void unmark_modified(handle);
+    void order_preserve_merge(handle, const region&);
 };
 
 
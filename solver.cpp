@@ -12,19 +12,92 @@ namespace ms {
 	 * Copies grid, all other members default initialize
 	 **/
 	solver::solver(const grid& start, grid::copy_type gct) : 
-		g(start, gct), regions(height(), width()) {	}
+		g(start, gct), regions(height(), width()), components(height(), width()), global(height(), width()), probabilities(height(), width()),
+		_seed(grid::random_seed()), rng(_seed) {	}
 
 	/**
 	 * Initializes the internal grid with the given parameters
 	 **/
 	solver::solver(unsigned int height, unsigned int width, unsigned int bombs) : 
-		g(height,width,bombs), regions(height, width) { }
+		g(height,width,bombs), regions(height, width), components(height, width), global(height, width), probabilities(height, width),
+		_seed(grid::random_seed()), rng(_seed) { }
 
 	/**
 	 * Copies all contents of solver, copies grid with the given copy type
 	 **/
 	solver::solver(const solver& copy, grid::copy_type gct) : 
-		g(copy.g, gct), regions(copy.regions) {}
+		g(copy.g, gct), regions(copy.regions), components(copy.components), global(copy.global), probabilities(copy.probabilities),
+		_seed(copy._seed), rng(copy.rng), regions_were_reset(copy.regions_were_reset),
+		safe_queue(copy.safe_queue), bomb_queue(copy.bomb_queue), modified_cells(copy.modified_cells), guessing(copy.guessing),
+		lookahead_depth(copy.lookahead_depth), lookahead_width(copy.lookahead_width), lookahead_budget(copy.lookahead_budget),
+		endgame_cells(copy.endgame_cells), endgame_nodes(copy.endgame_nodes),
+		endgame_time_budget(copy.endgame_time_budget), pool(copy.pool) {}
+
+	/**
+	 * Sets the number of threads used to derive regions in `find_aux_regions` and to compare
+	 * guesses in `step`, including the calling thread. `0` uses one thread per core. The regions
+	 * derived and the moves chosen do not depend on the number of threads.
+	 **/
+	void solver::set_threads(unsigned threads) {
+		if(threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		if(threads == this->threads())
+			return;
+		if(threads == 1)
+			pool.reset();
+		else
+			pool = std::make_shared<thread_pool>(threads);
+	}
+
+	/**
+	 * Seeds every random choice of the game from `seed`: the bombs placed by the grid when the game
+	 * starts (see `grid::set_seed`), the first move, the choice between equally good guesses and
+	 * the chains of the sampler. Two solvers with the same settings and seed play the same game,
+	 * unless a wall clock budget that was turned on (of the sampler, lookahead or endgame search) runs
+	 * out. The default settings have none.
+	 **/
+	void solver::set_seed(std::uint64_t seed) {
+		_seed = seed;
+		g.set_seed(seed);
+		std::seed_seq sequence{ std::uint32_t(seed), std::uint32_t(seed >> 32), std::uint32_t(1) };
+		rng.seed(sequence);
+		probabilities.get_sampler().set_seed(seed + 0x9e3779b97f4a7c15);
+	}
+
+	/**
+	 * Sets whether the probabilities of a frontier too large to enumerate are sampled (see `monte_carlo`)
+	 * instead of estimated from the smallest regions, until every cell is within `precision` with 95%
+	 * confidence or `budget` of wall clock time has passed. The chains are run on the solver's threads.
+	 **/
+	void solver::set_sampling(bool enabled, float precision, std::chrono::milliseconds budget) {
+		probabilities.set_sampling(enabled);
+		probabilities.get_sampler().set_precision(precision);
+		probabilities.get_sampler().set_time_budget(budget);
+	}
+
+	/**
+	 * Sets how far `step` searches in `LOOKAHEAD_GUESS` mode: at most `depth` guesses ahead, trying
+	 * the `width` cells least likely to be bombs at each guess, for at most `budget` of wall clock
+	 * time per move. A `depth` or `width` of 0 is treated as 1.
+	 **/
+	void solver::set_lookahead(unsigned depth, std::chrono::milliseconds budget, unsigned width) {
+		lookahead_depth = std::max(1u, depth);
+		lookahead_width = std::max(1u, width);
+		lookahead_budget = budget;
+	}
+
+	/**
+	 * Sets `step` to search every remaining layout for the move most likely to win (see `endgame`)
+	 * once at most `max_cells` cells are unopened, spending at most `node_budget` of work per move.
+	 * A `time_budget` other than 0 also stops each search after that much wall clock time, which
+	 * makes the moves depend on the speed of the machine. Moves whose search is cut short are
+	 * guessed as usual. A `max_cells` of 0 turns the search off.
+	 **/
+	void solver::set_endgame(unsigned max_cells, size_t node_budget, std::chrono::milliseconds time_budget) {
+		endgame_cells = std::min(max_cells, endgame::MAX_CELLS);
+		endgame_nodes = node_budget;
+		endgame_time_budget = time_budget;
+	}
 
 	/**
 	 * Find the areas around each number where there could be bombs.
@@ -41,9 +114,9 @@ namespace ms {
 	 * Complexity \f$O(N)\f$ where \f$N\f$ is the number of cells in the grid
 	 **/
 	int solver::find_base_regions() {
-		region remaining;
-
+		solver_stats::timer timed(_stats, solver_stats::FIND_BASE_REGIONS);
 		if(regions_were_reset) {
+			components.clear();
 			//all regions must be re-added
 			for (unsigned r = 0; r < height(); ++r) {
 				for(unsigned c = 0; c < width(); ++c) {
@@ -56,118 +129,226 @@ namespace ms {
 			unsigned r = cell.row, c = cell.col;
 			grid::cell gotten = get(r,c);
 			if(gotten <= 8 && gotten > 0) { //grid handles zeroes automatically
-				remaining.remove_safe(rc_coord(r,c));
 				region reg;
 				int num_flags = 0;
 
-				for (int rr = -1; rr <= 1; ++rr)
-					for (int cc = -1; cc <= 1; ++cc)
-						if (!(rr == 0 && cc == 0) && g.iscontained(r + rr, c + cc)) {
-							switch (get(r + rr, c + cc)) {
-							case grid::ms_hidden:
-							case grid::ms_question:
-								reg.add_cell(rc_coord(r + rr, c + cc));
-								break;
-							case grid::ms_flag:
-								++num_flags;
-								break;
-							default:
-								break;
-							}
-
-						}
+				unsigned index = g.index(r,c);
+				for (int offset : g.neighbor_offsets()) {
+					switch (g.get_at(index + offset)) {
+					case grid::ms_hidden:
+					case grid::ms_question:
+						reg.add_cell(g.coord(index + offset));
+						break;
+					case grid::ms_flag:
+						++num_flags;
+						break;
+					default: //includes ms_error past the edge of the grid
+						break;
+					}
+				}
 				if(!reg.empty()) {
 					if(gotten < num_flags)
 						throw bad_region_error("number of flags surrounding the cell exceeds the number of the cell");
 					reg.set_count(gotten - num_flags);
-					regions.add(reg);
+					_stats.count(solver_stats::BASE_REGIONS);
+					add_base_region(reg);
 				}
 			}
 		}
 		modified_cells.clear();
 
-		//this check is added to prevent massive slowdowns from adding remaining when it intersects around 100 cells -> 2000 cells
-		//the choice of 10 is somewhat arbitrary, TODO get a better system for deciding when to add remaining
-		if(g.count_unopened() < 10) {
-			for (unsigned int r = 0; r < height(); ++r) {
-				for (unsigned int c = 0; c < width(); ++c) {
-					remaining.add_cell(rc_coord(r,c));
-				}
-			}
-			remaining.set_count(bombs());
-			for (unsigned int r = 0; r < height(); ++r) {
-				for (unsigned int c = 0; c < width(); ++c) {
-					grid::cell gotten = get(r,c);
-					if(gotten == grid::ms_flag) {
-						remaining.remove_bomb(rc_coord(r,c));
-					} else if(gotten <= 8 && gotten >= 0) {
-						remaining.remove_safe(rc_coord(r,c));
-					}
-				}
-			}
-			assert(remaining.size() < 10);
-			regions.add(remaining);
-		}
-
 		return 0;
 	}
 
 
+	/**
+	 * Adds a region found from the grid (rather than derived from other regions) to `regions`,
+	 * and joins the frontier components of its cells.
+	 **/
+	void solver::add_base_region(const region& reg) {
+		add_region(reg);
+		components.link(reg);
+	}
+
+	/**
+	 * Adds a region to `regions`, counting whether it covered a new area or tightened a region
+	 * already there.
+	 **/
+	void solver::add_region(const region& reg) {
+		size_t before = regions.size();
+		bool changed = regions.add(reg).second;
+		if(regions.size() > before)
+			_stats.count(solver_stats::REGIONS_ADDED);
+		else if(changed)
+			_stats.count(solver_stats::REGIONS_MERGED);
+	}
+
+
 	/**
 	 * Find all regions that can be deduced from the existing regions.
 	 * 
-	 * Calculate the intersection of each pair of regions
-	 *   - if empty, discard it
-	 *   - if nonempty, add the intersection and subraction to `this.aux_regions`
+	 * The regions modified since the last call are grouped by their frontier component
+	 * (see `frontier`), and each component is worked on separately by `find_component_aux_regions`.
+	 * Regions derived from a component only contain cells of that component, so components
+	 * without changes are never looked at.
 	 * 
 	 * Returns the number iterations, (zero if nothing to do)
 	 * 
-	 * If `lazy == true` it stops as soon as a cells can be added to the queue
+	 * If `lazy == true` it stops as soon as a cells can be added to the queue. The regions of
+	 * components that were not finished are left marked as modified for the next call.
+	 **/
+	int solver::find_aux_regions(bool lazy) {
+		solver_stats::timer timed(_stats, solver_stats::FIND_AUX_REGIONS);
+		MS_TRACE(1, "find_aux_regions [" << (lazy?"lazy":"nonlazy") << "]...");
+
+		aux_components.clear();
+		for(region_set::handle h : regions.get_modified_regions()) {
+			aux_components.emplace_back(components.find(*regions[h].begin()), h);
+		}
+		std::sort(aux_components.begin(), aux_components.end());
+		regions.reset_modified_regions();
+
+		int iterations = 0;
+		size_t begin = 0;
+		while(begin < aux_components.size()) {
+			size_t end = begin;
+			aux_pending.clear();
+			for(; end < aux_components.size() && aux_components[end].first == aux_components[begin].first; ++end) {
+				aux_pending.push_back(aux_components[end].second);
+			}
+			MS_TRACE(2, "{" << aux_pending.size() << "}");
+			iterations += find_component_aux_regions(lazy);
+			begin = end;
+			if(!aux_pending.empty())
+				break; //stopped early
+		}
+		for(; begin < aux_components.size(); ++begin) {
+			regions.mark_modified(aux_components[begin].second);
+		}
+		MS_TRACE(2, "\n");
+		MS_TRACE(1, "done\n");
+		return iterations;
+	}
+
+	/**
+	 * Derives regions from the regions of a single frontier component until nothing changes,
+	 * starting from the regions in `aux_pending` (which must be sorted). `regions` must have
+	 * no modified regions when called.
+	 * 
+	 * Calculate the intersection of each pair of overlapping regions where at least one was modified,
+	 * and add the intersection and subtractions to `regions`.
+	 * 
+	 * The size and range of each derived region is calculated before it is built (see `region::split`),
+	 * and only regions that are helpful are built. Pairs where both regions were modified are only
+	 * checked once. Built regions are dropped if a region with the same area is already at least as tight.
+	 * 
+	 * When the solver has more than one thread (see `set_threads`) and there are enough pending regions,
+	 * the pairs are checked by all threads at once (see `derive_aux_regions`).
+	 * 
+	 * If `lazy == true` it stops as soon as a cells can be added to the queue, putting the regions
+	 * still to be checked back in the modified regions and leaving them in `aux_pending`.
+	 * Otherwise `aux_pending` is empty on return.
+	 * 
+	 * Returns the number of iterations.
 	 * 
 	 * Complexity of the inner loop \f$O(N^2)\f$ where N is the number of regions modified since last time the loop was reached
 	 * Outer loop's complexity is nontrivial, runs until it has found aux regions. Often just one or zero iteration,
 	 * but if there is nothing to be found, there are often around 10-20 (more when more regions).
 	 **/
-	int solver::find_aux_regions(bool lazy) {
-		dbg::cout << "find_aux_regions [" <<  (lazy?"lazy":"nonlazy") << "]...";
-		
+	int solver::find_component_aux_regions(bool lazy) {
 		int iterations = 0;
 
-		const region_set::subset_type& regions_added = regions.get_modified_regions();
+		while (!aux_pending.empty()) { //loops as long as something was added
+			MS_TRACE(2, "[" << aux_pending.size() << "," << regions.size() << "]");
 
-		while (!regions_added.empty()) { //loops as long as something was added
-			dbg::cout2 << "[" << regions_added.size() << "," << regions.size() << "]";
-
-			if(lazy && fill_queue())
+			if(lazy && fill_queue()) {
+				for(region_set::handle h : aux_pending) {
+					regions.mark_modified(h);
+				}
 				break;
+			}
 
-			std::vector<region> region_queue;
-
-			for(auto ri = regions_added.begin(); ri != regions_added.end(); ++ri) {
-				dbg::cout2 << ".";
-				region_set::subset_type overlaps = regions.regions_intersecting(**ri);
-				
-				for(auto rj = overlaps.begin(); rj != overlaps.end(); ++rj) {
-					if(*rj == *ri)
-						continue;
-					region_queue.push_back((*ri)->intersect(**rj));
-					region_queue.push_back((*ri)->subtract(**rj));
-					region_queue.push_back((*rj)->subtract(**ri));
+			//the pairs are split between the workers, and their candidates added in worker order
+			//so the regions added are the same as with a single thread
+			size_t workers = pool && aux_pending.size() >= PARALLEL_AUX_MIN ? pool->size() : 1;
+			if(aux_buffers.size() < workers)
+				aux_buffers.resize(workers);
+			if(workers == 1) {
+				derive_aux_regions(0, aux_pending.size(), aux_buffers[0]);
+			} else {
+				pool->parallel_for(aux_pending.size(), [this](size_t begin, size_t end, unsigned worker) {
+					derive_aux_regions(begin, end, aux_buffers[worker]);
+				});
+			}
+			MS_TRACE(2, "*");
+			for(size_t worker = 0; worker < workers; ++worker) {
+				_stats.count(solver_stats::AUX_PAIRS, aux_buffers[worker].pairs);
+				_stats.count(solver_stats::AUX_CANDIDATES, aux_buffers[worker].built);
+				_stats.count(solver_stats::AUX_CANDIDATES_KEPT, aux_buffers[worker].candidates.size());
+				for(region& to_add : aux_buffers[worker].candidates) {
+					add_region(to_add);
 				}
 			}
-			dbg::cout2 << "*";
+			aux_pending = regions.get_modified_regions();
+			std::sort(aux_pending.begin(), aux_pending.end());
 			regions.reset_modified_regions();
-			for(region& to_add : region_queue) {
-				regions.add(to_add);
-			}
 			++iterations;
+			_stats.count(solver_stats::AUX_ITERATIONS);
 		}
-		dbg::cout2 << "\n";
-		dbg::cout << "done\n";
 		return iterations;
 	}
 
 
+	/**
+	 * Derives regions from the pairs of overlapping regions where the first region is
+	 * `aux_pending[begin]` to `aux_pending[end - 1]`, replacing the candidates in `out`.
+	 * 
+	 * Does not change the solver, so it can be run on several ranges at the same time.
+	 **/
+	void solver::derive_aux_regions(size_t begin, size_t end, aux_buffer& out) const {
+		out.candidates.clear();
+		out.pairs = 0;
+		out.built = 0;
+		for(size_t i = begin; i < end; ++i) {
+			region_set::handle ri = aux_pending[i];
+			const region& reg_i = regions[ri];
+			regions.regions_intersecting(reg_i, out.overlaps);
+			
+			for(region_set::handle rj : out.overlaps) {
+				if(rj == ri)
+					continue;
+				if(rj < ri && std::binary_search(aux_pending.begin(), aux_pending.end(), rj))
+					continue; //the pair is checked when rj is reached in the outer loop
+				const region& reg_j = regions[rj];
+				++out.pairs;
+				region_split bounds = reg_i.split(reg_j);
+				if(bounds.common.is_helpful() || !bounds.common.is_reasonable())
+					queue_aux_region(reg_i.intersect(reg_j), out);
+				if(bounds.this_only.is_helpful() || !bounds.this_only.is_reasonable())
+					queue_aux_region(reg_i.subtract(reg_j), out);
+				if(bounds.arg_only.is_helpful() || !bounds.arg_only.is_reasonable())
+					queue_aux_region(reg_j.subtract(reg_i), out);
+			}
+		}
+	}
+
+	/**
+	 * Adds a region derived by find_aux_regions to the candidates in `out`, unless a region with the same area
+	 * is already in `regions` with a range at least as tight, in which case adding it would do nothing.
+	 * 
+	 * Complexity \f$O(1)\f$
+	 **/
+	void solver::queue_aux_region(region&& candidate, aux_buffer& out) const {
+		++out.built;
+		if(candidate.is_reasonable()) {
+			region_set::handle existing = regions.find(candidate);
+			if(existing != region_set::NO_REGION && regions[existing].min() >= candidate.min() && regions[existing].max() <= candidate.max())
+				return;
+		}
+		out.candidates.push_back(std::move(candidate));
+	}
+
+
 	int solver::find_regions() {
 		find_base_regions();
 		find_aux_regions(true);
@@ -188,9 +369,8 @@ namespace ms {
 	int solver::remove_safe(rc_coord cell) {
 		int removed = regions.remove_safe(cell);	
 
-		auto it = safe_queue.find(cell);
-		if(it != safe_queue.end())
-			safe_queue.erase(it);
+		if(safe_queue.erase(cell))
+			record_queue_change(cell, false, false);
 		assert(bomb_queue.find(cell) == bomb_queue.end());
 		
 		return removed;
@@ -206,18 +386,47 @@ namespace ms {
 	int solver::remove_bomb(rc_coord cell) {
 		int removed = regions.remove_bomb(cell);
 
-		auto it = bomb_queue.find(cell);
-		if(it != bomb_queue.end())
-			bomb_queue.erase(it);
+		if(bomb_queue.erase(cell))
+			record_queue_change(cell, true, false);
 		assert(safe_queue.find(cell) == safe_queue.end());
 
 		return removed;
 	}
 
+	/**
+	 * To be called when many cells are opened or flagged at once.
+	 * Removes all of them from the regions in one pass (see `region_set::resolve_cells`)
+	 * and from the queues.
+	 * 
+	 * returns the number of regions that contained any of the cells
+	 **/
+	int solver::resolve_cells(const std::vector<rc_coord>& safe, const std::vector<rc_coord>& bombs) {
+		int removed = regions.resolve_cells(safe, bombs);
+
+		for(rc_coord cell : safe) {
+			if(safe_queue.erase(cell))
+				record_queue_change(cell, false, false);
+			assert(bomb_queue.find(cell) == bomb_queue.end());
+		}
+		for(rc_coord cell : bombs) {
+			if(bomb_queue.erase(cell))
+				record_queue_change(cell, true, false);
+			assert(safe_queue.find(cell) == safe_queue.end());
+		}
+
+		return removed;
+	}
+
+	/**
+	 * Returns the first cell of the safe queue, the same one however the queue was filled.
+	 **/
 	rc_coord solver::get_safe_from_queue() const {
 		return *safe_queue.begin();
 	}
 
+	/**
+	 * Returns the first cell of the bomb queue, the same one however the queue was filled.
+	 **/
 	rc_coord solver::get_bomb_from_queue() const {
 		return *bomb_queue.begin();
 	}
@@ -279,19 +488,17 @@ namespace ms {
 	}
 
 	/**
-	 * Opens a cell and removes all instances of the cell from all regions
+	 * Opens a cell and removes all opened cells from all regions in one pass
 	 * 
 	 * Returns the number of cells opened, or -1 on error
 	 **/
 	int solver::apply_open(rc_coord arg) {
-		std::unordered_set<rc_coord, rc_coord_hash> cells_opened = g.open(arg.row, arg.col);
+		g.open(arg.row, arg.col, opened_cells);
 
-		for (rc_coord cell : cells_opened) {
-			remove_safe(cell);
-			modified_cells.insert(cell);
-		}
+		modified_cells.insert(opened_cells.begin(), opened_cells.end());
+		resolve_cells(opened_cells, {});
 
-		return cells_opened.size();
+		return opened_cells.size();
 	}
 
 	/**
@@ -299,17 +506,31 @@ namespace ms {
 	 **/
 	int solver::reset_regions() {
 		regions.clear();
+		for(rc_coord cell : safe_queue)
+			record_queue_change(cell, false, false);
+		for(rc_coord cell : bomb_queue)
+			record_queue_change(cell, true, false);
+		safe_queue.clear();
+		bomb_queue.clear();
 		regions_were_reset = true;
 		return 0;
 	}
 
 	/**
-	 * Finds all regions that guarantee that the contained cells are
-	 * safe or bombs and adds them to the queues if they are not already.
+	 * Adds the cells of all regions that became determined since the last call
+	 * (see `region_set::get_determined_regions`) to the safe or bomb queue.
+	 * 
+	 * Returns the number of cells added to the queues.
+	 * 
+	 * Complexity \f$O(M)\f$ where \f$M\f$ is the total size of the newly determined regions
 	 **/
 	int solver::fill_queue() {
+		solver_stats::timer timed(_stats, solver_stats::FILL_QUEUE);
 		int num_added = 0;
-		for(const region& check : regions) {
+		for(region_set::handle h : regions.get_determined_regions()) {
+			if(!regions.is_valid(h))
+				continue;
+			const region& check = regions[h];
 			if(check.size() == check.min()) { //implies size == max == min for all valid state regions
 				for(rc_coord bomb : check) {
 					num_added += add_to_bomb_queue(bomb);
@@ -320,127 +541,282 @@ namespace ms {
 				}				
 			}
 		}
+		regions.reset_determined_regions();
 		return num_added;
 	}
 
 	/**
-	 * Adds the input cell to the back of the bomb queue if it is not already present.
+	 * Adds the hidden cells outside of a family of disjoint regions to the safe or bomb queue if
+	 * the number of bombs left shows they are all safe or all bombs (see `global_constraint`).
+	 * 
+	 * Returns the number of cells added to the queues.
+	 * 
+	 * Complexity \f$O(R \log R + N)\f$ where \f$R\f$ is the number of regions and \f$N\f$ the number of cells in them
+	 * or unopened
+	 **/
+	int solver::fill_global_queue() {
+		solver_stats::timer timed(_stats, solver_stats::FILL_GLOBAL_QUEUE);
+		global.update(g);
+		global_constraint::deduction found = global.deduce(regions);
+		if(found == global_constraint::NONE)
+			return 0;
+		int num_added = 0;
+		for (unsigned index = g.next_unopened(0); index < g.index_end(); index = g.next_unopened(index + 1)) {
+			rc_coord cell = g.coord(index);
+			if(g.get_at(index) != grid::ms_flag && !global.covers(cell)) {
+				if(found == global_constraint::OUTSIDE_SAFE)
+					num_added += add_to_safe_queue(cell);
+				else
+					num_added += add_to_bomb_queue(cell);
+			}
+		}
+		return num_added;
+	}
+
+	/**
+	 * Adds the input cell to the bomb queue if it is not already present.
 	 * 
 	 * Returns 1 if `to_add` is added, 0 if not.
+	 * 
+	 * Complexity \f$O(log(N))\f$ where \f$N\f$ is the number of cells in the bomb queue
 	 **/
 	int solver::add_to_bomb_queue(rc_coord to_add) {
-		for(const rc_coord& check : bomb_queue) {
-			if(to_add == check)
-				return 0;
-		}
-		bomb_queue.insert(to_add);
+		if(!bomb_queue.insert(to_add).second)
+			return 0;
+		_stats.count(solver_stats::CELLS_QUEUED);
+		record_queue_change(to_add, true, true);
 		return 1;
 	}
 
 	/**
-	 * Adds the input cell to the back of the safe queue if it is not already present.
+	 * Adds the input cell to the safe queue if it is not already present.
 	 * 
 	 * Returns 1 if `to_add` is added, 0 if not.
+	 * 
+	 * Complexity \f$O(log(N))\f$ where \f$N\f$ is the number of cells in the safe queue
 	 **/
 	int solver::add_to_safe_queue(rc_coord to_add) {
-		for(const rc_coord& check : safe_queue) {
-			if(to_add == check)
-				return 0;
-		}
-		safe_queue.insert(to_add);
+		if(!safe_queue.insert(to_add).second)
+			return 0;
+		_stats.count(solver_stats::CELLS_QUEUED);
+		record_queue_change(to_add, false, true);
 		return 1;
 	}
 
-	region solver::approx_remain() const {
-		region ret_base;
-		for(unsigned r = 0; r < height(); ++r) {
-			for(unsigned c = 0; c < width(); ++c) {
-				ret_base.add_cell(rc_coord(r,c));
-			}
+	/**
+	 * Starts recording every change to the grid's visible state, the regions and the queues,
+	 * so that a hypothetical move can be analysed and then undone by `rollback` in time
+	 * proportional to what it changed. Checkpoints nest.
+	 **/
+	void solver::checkpoint() {
+		_stats.count(solver_stats::CHECKPOINTS);
+		g.checkpoint();
+		regions.checkpoint();
+		components.checkpoint();
+		checkpoints.push_back(checkpoint_state{ queue_trail.size(), modified_cells, regions_were_reset });
+	}
+
+	/**
+	 * Undoes every change since the most recent checkpoint, and removes the checkpoint.
+	 * 
+	 * Complexity \f$O(C \cdot log(N))\f$ for the queues, where \f$C\f$ is the number of changes to
+	 * them and \f$N\f$ the number of cells queued
+	 **/
+	void solver::rollback() {
+		assert(!checkpoints.empty());
+		checkpoint_state& state = checkpoints.back();
+		while(queue_trail.size() > state.queue_trail_size) {
+			const queue_change& change = queue_trail.back();
+			std::set<rc_coord>& queue = change.bomb ? bomb_queue : safe_queue;
+			if(change.inserted)
+				queue.erase(change.cell);
+			else
+				queue.insert(change.cell);
+			queue_trail.pop_back();
 		}
-		ret_base.set_count(bombs());
-		for(unsigned r = 0; r < height(); ++r) {
-			for(unsigned c = 0; c < width(); ++c) {
-				switch(get(r,c)) {
-				case grid::ms_flag:
-					ret_base.remove_bomb(rc_coord(r,c));
-					break;
-				case grid::ms_hidden:
-				case grid::ms_question:
-					break;
-				default:
-					ret_base.remove_safe(rc_coord(r,c));
-				}
-			}
+		modified_cells = std::move(state.modified_cells);
+		regions_were_reset = state.regions_were_reset;
+		checkpoints.pop_back();
+		components.rollback();
+		regions.rollback();
+		g.rollback();
+	}
+
+	void solver::record_queue_change(rc_coord cell, bool bomb, bool inserted) {
+		if(!checkpoints.empty())
+			queue_trail.push_back(queue_change{ cell, bomb, inserted });
+	}
+
+	/**
+	 * Estimates how many cells could be opened or flagged after opening `cell`.
+	 * 
+	 * Each number the cell could show is assumed in turn between a `checkpoint` and a `rollback`,
+	 * and the regions derived from it are counted, weighted by how many ways there are to place
+	 * that many bombs around the cell. The solver is unchanged when it returns.
+	 * 
+	 * Returns -1 if no number is possible, meaning the cell must be a bomb.
+	 **/
+	float solver::expected_payout(rc_coord cell) {
+		unsigned flags;
+		region base = payout_base(cell, flags);
+		payout_outcome outcomes[9];
+		for(unsigned count = 0; count <= base.size(); ++count) {
+			outcomes[count] = assume_count(cell, base, flags, count);
 		}
-		std::vector<region_set::const_iterator> random_regions;
-		for(region_set::const_iterator it = regions.cbegin(); it != regions.cend(); ++it) {
-			random_regions.push_back(it);
-		}
-		//number of iterations arbitrary, the more iterations the closer to actual results you get
-		region ret;
-		for(int i = 0; i < 10; ++i) {
-			region to_merge = ret_base;
-			std::shuffle(random_regions.begin(), random_regions.end(), rng);
-			for(region_set::iterator it : random_regions) {
-				to_merge.subtract_to(*it);
-			}
-			if(ret.empty()) {
-				ret = to_merge;
-			} else {
-				ret.merge_to(to_merge);
+		return combine_payouts(outcomes);
+	}
+
+	/**
+	 * Returns `expected_payout` of each cell, in the same order.
+	 * 
+	 * When the solver has more than one thread (see `set_threads`), every pair of a cell and a
+	 * number it could show is evaluated as its own task. Each worker evaluates its tasks on its own
+	 * snapshot of the solver (see `refresh_snapshot`), and the outcomes are stored by task and
+	 * combined in order, so the results are the same as calling `expected_payout` on each cell.
+	 **/
+	std::vector<float> solver::expected_payouts(const std::vector<rc_coord>& cells) {
+		solver_stats::timer timed(_stats, solver_stats::EXPECTED_PAYOUT);
+		std::vector<float> ret;
+		if(!pool || cells.size() < 2) {
+			for(rc_coord cell : cells)
+				ret.push_back(expected_payout(cell));
+			return ret;
+		}
+
+		struct payout_task {
+			size_t cell;
+			unsigned count;
+		};
+		std::vector<region> bases;
+		std::vector<unsigned> flags(cells.size());
+		std::vector<payout_task> tasks;
+		for(size_t i = 0; i < cells.size(); ++i) {
+			bases.push_back(payout_base(cells[i], flags[i]));
+			for(unsigned count = 0; count <= bases[i].size(); ++count)
+				tasks.push_back(payout_task{ i, count });
+		}
+
+		//each worker only changes its own snapshot, so tasks never share state
+		while(payout_snapshots.size() < pool->size()) {
+			payout_snapshots.emplace_back(new solver(g, grid::SURFACE_COPY));
+			_stats.count(solver_stats::SOLVER_COPIES);
+		}
+		std::vector<std::array<payout_outcome, 9>> outcomes(cells.size());
+		pool->parallel_for(tasks.size(), [&](size_t begin, size_t end, unsigned worker) {
+			if(begin == end)
+				return;
+			solver& snapshot = *payout_snapshots[worker];
+			refresh_snapshot(snapshot);
+			for(size_t t = begin; t < end; ++t) {
+				const payout_task& task = tasks[t];
+				outcomes[task.cell][task.count] = 
+					snapshot.assume_count(cells[task.cell], bases[task.cell], flags[task.cell], task.count);
 			}
+		});
+
+		for(const std::unique_ptr<solver>& snapshot : payout_snapshots) {
+			_stats.merge(snapshot->_stats);
+			snapshot->_stats.reset();
 		}
+		for(const std::array<payout_outcome, 9>& cell_outcomes : outcomes)
+			ret.push_back(combine_payouts(cell_outcomes.data()));
 		return ret;
 	}
 
-	float solver::expected_payout(rc_coord cell) const {
-		using boost::math::factorial;
+	/**
+	 * Makes `snapshot`, a single threaded solver for a grid of the same size, evaluate `assume_count`
+	 * the same way as this solver, by copying only the state it reads and changes: the visible grid,
+	 * the regions and their components, and the queues. The storage of `snapshot` is reused, so
+	 * refreshing it between moves rarely allocates.
+	 * 
+	 * Does not change this solver, so several snapshots can be refreshed at the same time.
+	 **/
+	void solver::refresh_snapshot(solver& snapshot) const {
+		snapshot.g.copy_surface(g);
+		snapshot.regions = regions;
+		snapshot.components = components;
+		snapshot.safe_queue = safe_queue;
+		snapshot.bomb_queue = bomb_queue;
+		snapshot.modified_cells = modified_cells;
+		snapshot.regions_were_reset = regions_were_reset;
+		snapshot._stats.count(solver_stats::SNAPSHOT_REFRESHES);
+	}
 
-		float payout[9] = { 0 };
-		float permutations[9] = { 0 };
-		region new_base;
-		for(int r = -1; r <= 1; ++r) {
-			for(int c = -1; c <= 1; ++c) {
-				if((c != 0 || r != 0) && g.iscontained(cell.row + r, cell.col + c)) {
-					grid::cell value = get(cell.row + r, cell.col + c);
-					if(value == grid::ms_hidden || value == grid::ms_question)
-						new_base.add_cell(rc_coord(cell.row + r, cell.col + c));
-				}
-			}
+	/**
+	 * Returns the region of hidden cells around `cell`, and sets `flags` to the number of flags around it.
+	 **/
+	region solver::payout_base(rc_coord cell, unsigned& flags) const {
+		region base;
+		flags = 0;
+		unsigned index = g.index(cell.row, cell.col);
+		for(int offset : g.neighbor_offsets()) {
+			grid::cell value = g.get_at(index + offset);
+			if(value == grid::ms_hidden || value == grid::ms_question)
+				base.add_cell(g.coord(index + offset));
+			else if(value == grid::ms_flag)
+				++flags;
 		}
-		for(unsigned count = 0; count <= 8; ++count) {
-			try {
-				new_base.set_count(count);
-				solver test(*this, grid::SURFACE_COPY);
-				test.apply_open(cell);
-				test.regions.add(new_base);
-				test.find_aux_regions(false);
-				payout[count] += test.safe_queue.size() + test.bomb_queue.size() / 1.5f; //opening safe cells is worth a bit more than flagging cells
-
-				//restrict the set of possible locations of bombs around the openned cell
-				//to get a better estimate of how likely a certain number is
-				region final_base = new_base;
-				final_base.set_count(count);
-				for(rc_coord cell : new_base) {
-					if(test.safe_queue.find(cell) != test.safe_queue.end()) {
-						final_base.remove_safe(cell);
-					} else if (test.bomb_queue.find(cell) != test.bomb_queue.end()) {
-						final_base.remove_bomb(cell);
-					}
+		return base;
+	}
+
+	/**
+	 * Assumes `cell` shows `count` bombs among the hidden cells of `base` (see `payout_base`), and
+	 * returns the number of cells that could then be opened or flagged, along with the number of
+	 * ways to place the bombs around the cell. Both are 0 if the number is not possible.
+	 * 
+	 * If `depth` is not 0, the value of the resulting position searched `depth` guesses further
+	 * (see `lookahead`) is added to the payout.
+	 * 
+	 * The solver is unchanged when it returns.
+	 **/
+	solver::payout_outcome solver::assume_count(rc_coord cell, region base, unsigned flags, unsigned count, unsigned depth) {
+		using boost::math::factorial;
+
+		payout_outcome ret;
+		//a cell already known to be safe is not counted when it leaves the queue
+		size_t safe_before = safe_queue.size() - safe_queue.count(cell), bomb_before = bomb_queue.size();
+		base.set_count(count);
+		checkpoint();
+		try {
+			g.assume(cell.row, cell.col, grid::cell(count + flags));
+			resolve_cells({ cell }, {});
+			add_base_region(base);
+			find_aux_regions(false);
+			if(!fill_queue())
+				fill_global_queue();
+			//opening safe cells is worth a bit more than flagging cells
+			ret.payout = (safe_queue.size() - safe_before) + (bomb_queue.size() - bomb_before) / 1.5f;
+
+			//restrict the set of possible locations of bombs around the openned cell
+			//to get a better estimate of how likely a certain number is
+			region final_base = base;
+			for(rc_coord cell : base) {
+				if(safe_queue.find(cell) != safe_queue.end()) {
+					final_base.remove_safe(cell);
+				} else if (bomb_queue.find(cell) != bomb_queue.end()) {
+					final_base.remove_bomb(cell);
 				}
-				permutations[count] = factorial<float>(final_base.size()) / 
-					(factorial<float>(final_base.size() - final_base.max()) * factorial<float>(final_base.max()));
-			} catch (const bad_region_error& e) {
-				payout[count] = 0;
-				permutations[count] = 0;
 			}
+			ret.permutations = factorial<float>(final_base.size()) / 
+				(factorial<float>(final_base.size() - final_base.max()) * factorial<float>(final_base.max()));
+			if(depth > 0 && ret.permutations > 0)
+				ret.payout += lookahead(depth, nullptr);
+		} catch (const bad_region_error& e) {
+			ret = payout_outcome();
 		}
+		rollback();
+		return ret;
+	}
+
+	/**
+	 * Combines the outcomes of each number a cell could show into its expected payout, or -1 if no number is possible.
+	 **/
+	float solver::combine_payouts(const payout_outcome* outcomes) {
 		float num = 0;
 		int den = 0;
 		for(unsigned count = 0; count <= 8; ++count) {
-			num += payout[count] * permutations[count];
-			den += permutations[count];
+			num += outcomes[count].payout * outcomes[count].permutations;
+			den += outcomes[count].permutations;
 		}
 		if(den == 0) {
 			return -1;
@@ -450,6 +826,95 @@ namespace ms {
 	}
 
 
+	/**
+	 * Computes the probability of each hidden cell from the current regions (see `probability_map`).
+	 **/
+	void solver::compute_probabilities() {
+		solver_stats::timer timed(_stats, solver_stats::PROBABILITIES);
+		probabilities.compute(g, regions, components, pool.get());
+	}
+
+	/**
+	 * Chooses a cell to guess by searching `lookahead_depth` guesses ahead, with iterative deepening
+	 * so that the best cell of the deepest finished search is returned when the time budget runs out.
+	 * 
+	 * Returns `BAD_RC_COORD` if there is no hidden cell.
+	 **/
+	rc_coord solver::plan_guess() {
+		solver_stats::timer timed(_stats, solver_stats::LOOKAHEAD);
+		lookahead_deadline = std::chrono::steady_clock::now() + lookahead_budget;
+		lookahead_timed_out = false;
+		transpositions.clear();
+		rc_coord ret = BAD_RC_COORD;
+		for(unsigned depth = 1; depth <= lookahead_depth && !lookahead_timed_out; ++depth) {
+			rc_coord move = BAD_RC_COORD;
+			lookahead(depth, &move);
+			if(move != BAD_RC_COORD && (!lookahead_timed_out || ret == BAD_RC_COORD))
+				ret = move;
+		}
+		return ret;
+	}
+
+	/**
+	 * Returns the value of guessing in the current position, searched `depth` guesses ahead: the
+	 * greatest, over the `lookahead_width` cells least likely to be bombs, of the chance the cell
+	 * is safe times the expected payout of opening it. The payout of each number the cell could
+	 * show (a chance node, see `assume_count`) includes the value of the position after it,
+	 * searched one guess less deep.
+	 * 
+	 * Positions are looked up in and stored to `transpositions`. If `best_move` is not null, it
+	 * is set to the best cell, or the cell least likely to be a bomb if none was searched. Once the
+	 * deadline passes the search stops, sets `lookahead_timed_out`, and returns the best value of
+	 * the cells searched so far.
+	 **/
+	float solver::lookahead(unsigned depth, rc_coord* best_move) {
+		std::uint64_t key = g.hash();
+		float best = 0;
+		if(best_move == nullptr && transpositions.lookup(key, depth, best))
+			return best;
+
+		compute_probabilities();
+		std::vector<std::pair<float, rc_coord>> candidates;
+		for(unsigned row = 0; row < height(); ++row) {
+			for(unsigned col = 0; col < width(); ++col) {
+				if(get(row,col) == grid::ms_hidden || get(row,col) == grid::ms_question)
+					candidates.emplace_back(probabilities.get(rc_coord(row, col)), rc_coord(row, col));
+			}
+		}
+		size_t considered = std::min<size_t>(lookahead_width, candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin() + considered, candidates.end(),
+			[](const std::pair<float, rc_coord>& a, const std::pair<float, rc_coord>& b) {
+				return a.first < b.first || (a.first == b.first && a.second < b.second);
+			});
+		candidates.resize(considered);
+		if(best_move != nullptr && !candidates.empty())
+			*best_move = candidates.front().second;
+
+		for(const std::pair<float, rc_coord>& candidate : candidates) {
+			if(std::chrono::steady_clock::now() > lookahead_deadline)
+				lookahead_timed_out = true;
+			if(lookahead_timed_out)
+				return best;
+			rc_coord cell = candidate.second;
+			unsigned flags;
+			region base = payout_base(cell, flags);
+			payout_outcome outcomes[9];
+			for(unsigned count = 0; count <= base.size() && !lookahead_timed_out; ++count) {
+				outcomes[count] = assume_count(cell, base, flags, count, depth - 1);
+			}
+			float value = (1 - candidate.first) * std::max(0.f, combine_payouts(outcomes));
+			if(lookahead_timed_out)
+				return best;
+			if(best_move != nullptr && value > best)
+				*best_move = cell;
+			best = std::max(best, value);
+		}
+		if(!lookahead_timed_out)
+			transpositions.store(key, depth, best);
+		return best;
+	}
+
+
 	/**
 	 * Runs until the next step is not guaranteed to succeed.
 	 * 
@@ -481,12 +946,14 @@ namespace ms {
 					find_regions();
 					fill_queue();
 				}
+				if(bomb_queue.empty() && safe_queue.empty())
+					fill_global_queue();
 			}
 
 			if(!bomb_queue.empty()) {
 				rc_coord ret = get_bomb_from_queue();
 				apply_flag(ret);
-				dbg::cout << "flagged: " << ret << "\n";
+				MS_TRACE(1, "flagged: " << ret << "\n");
 				return ret;
 			} else if(!safe_queue.empty()) {
 				rc_coord ret = get_safe_from_queue();
@@ -497,7 +964,7 @@ namespace ms {
 				if(!(open_status > 0)) {
 					throw bad_region_error("Opened the wrong number of cells");
 				}
-				dbg::cout << "opened: " << ret << "\n";
+				MS_TRACE(1, "opened: " << ret << "\n");
 				return ret;
 			} else {
 				return BAD_RC_COORD;
@@ -514,7 +981,15 @@ namespace ms {
 		}
 	}
 
-	std::mt19937 solver::rng(time(NULL));
+	/**
+	 * Computes the probability of each cell being a bomb from the current regions and returns them.
+	 **/
+	const probability_map& solver::get_probabilities() {
+		if(g.gamestate() == grid::RUNNING)
+			find_base_regions();
+		compute_probabilities();
+		return probabilities;
+	}
 
 	/**
 	 * Runs until win or loss.
@@ -535,7 +1010,7 @@ namespace ms {
 	 * Returns the cell opened, or BAD_RC_COORD if none is opened
 	 **/
 	rc_coord solver::step() {
-		dbg::cout2 << ">";
+		MS_TRACE(2, ">");
 		if(g.gamestate() == grid::NEW) {
 			std::uniform_int_distribution<> uid_row(0, height() - 1);
 			std::uniform_int_distribution<> uid_col(0, width() - 1);
@@ -552,38 +1027,40 @@ namespace ms {
 			return ret;
 		}
 
-		region remain = approx_remain();
+		if(endgame_cells > 0 && g.count_unopened() <= int(endgame_cells)) {
+			bool solved;
+			{
+				solver_stats::timer timed(_stats, solver_stats::ENDGAME);
+				solved = endgame_time_budget.count() > 0 ?
+					endgame_search.solve(g, endgame_nodes, std::chrono::steady_clock::now() + endgame_time_budget) :
+					endgame_search.solve(g, endgame_nodes);
+			}
+			if(solved) {
+				ret = endgame_search.best_move();
+				apply_open(ret);
+				return ret;
+			}
+		}
+
+		if(guessing == LOOKAHEAD_GUESS) {
+			ret = plan_guess();
+			if(ret != BAD_RC_COORD) {
+				apply_open(ret);
+				return ret;
+			}
+		}
+
+		compute_probabilities();
 
 		std::vector<rc_coord> best_locs;
 		float best_prob = 2; //higher than any real probability could be
-		float default_prob = (remain.min() + remain.max()) / (2.f * remain.size()); //note that output could be infinite
+		float default_prob = probabilities.unconstrained();
 		constexpr float threshhold = .001;
 
 		for(unsigned row = 0; row < height(); ++row) {
 			for(unsigned col = 0; col < width(); ++col) {
 				if(get(row,col) == grid::ms_hidden || get(row,col) == grid::ms_question) {
-					const region_set::subset_type& regions_at = regions.regions_intersecting(rc_coord(row, col));
-					//select the smallest regions since they are most relevant
-					std::vector<region_set::iterator> smallest_regions;
-					for(region_set::iterator reg : regions_at) {
-						if(smallest_regions.empty()) {
-							smallest_regions.push_back(reg);
-						} else if (reg->size() < smallest_regions.front()->size()) {
-							smallest_regions.clear();
-							smallest_regions.push_back(reg);
-						} else if (reg->size() == smallest_regions.front()->size()) {
-							smallest_regions.push_back(reg);
-						}
-					}
-					float probability = 0;
-					if(smallest_regions.empty()) {
-						probability = default_prob;
-					} else {
-						for(region_set::iterator reg : smallest_regions) {
-							probability +=  reg->min() + reg->max();
-						}
-						probability /= 2 * smallest_regions.size() * smallest_regions.front()->size();
-					}
+					float probability = probabilities.get(rc_coord(row, col));
 
 					if(fabs(probability - best_prob) < threshhold) { //close enough in probability
 						best_locs.push_back(rc_coord(row,col));
@@ -599,8 +1076,10 @@ namespace ms {
 		std::vector<rc_coord> payout_locs;
 		float best_payout = 0;
 		if(best_locs.size() > 1 && fabs(best_prob - default_prob) > threshhold) {
-			for(rc_coord cell : best_locs) {
-				float payout = expected_payout(cell);
+			std::vector<float> payouts = expected_payouts(best_locs);
+			for(size_t i = 0; i < best_locs.size(); ++i) {
+				rc_coord cell = best_locs[i];
+				float payout = payouts[i];
 				if(fabs(best_payout - payout) < threshhold) {
 					payout_locs.push_back(cell);
 				} else if (payout >= best_payout) {
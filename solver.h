@@ -2,12 +2,24 @@
 #define MS_SOLVER_H
 
 #include <vector>
+#include <array>
 #include <set>
+#include <unordered_set>
 #include <list>
 #include <cassert>
+#include <memory>
+#include <random>
+#include <chrono>
 #include "grid.h"
 #include "region.h"
 #include "region_set.h"
+#include "frontier.h"
+#include "global_constraint.h"
+#include "thread_pool.h"
+#include "probability.h"
+#include "transposition_table.h"
+#include "endgame.h"
+#include "solver_stats.h"
 
 /**
  * 
@@ -27,6 +39,16 @@ namespace ms {
 	 **/
 	class solver {
 	public:
+		/**
+		 * How `step` chooses a cell when no cell is certain to be safe
+		 **/
+		enum guess_mode {
+			/**Among the cells least likely to be bombs, open the one that reveals the most on the next move**/
+			PAYOUT_GUESS,
+			/**Search several guesses ahead, see `set_lookahead`**/
+			LOOKAHEAD_GUESS
+		};
+
 		solver(const solver& copy, grid::copy_type gct);
 		solver(const grid& g, grid::copy_type gct = grid::FULL_COPY);
 		solver(unsigned int height, unsigned int width, unsigned int bombs);
@@ -53,18 +75,119 @@ namespace ms {
 		unsigned height() const { return g.height(); }
 		grid::cell get(unsigned row, unsigned col) const { return g.get(row,col); }
 		int remaining_bombs() const { return g.remaining_bombs(); }
+
+		const probability_map& get_probabilities();
+		/**Sets the most backtracking nodes spent on one frontier component when computing probabilities (see `probability_map`).*/
+		void set_probability_budget(size_t nodes) { probabilities.set_node_budget(nodes); }
+		void set_sampling(bool enabled, float precision = monte_carlo::DEFAULT_PRECISION,
+			std::chrono::milliseconds budget = monte_carlo::DEFAULT_TIME_BUDGET);
+
+		void set_threads(unsigned threads);
+		/**Returns the number of threads used to derive regions and compare guesses.*/
+		unsigned threads() const { return pool ? pool->size() : 1; }
+
+		/**Sets how `step` chooses a cell when no cell is certain to be safe.*/
+		void set_guess_mode(guess_mode mode) { guessing = mode; }
+		guess_mode get_guess_mode() const { return guessing; }
+		void set_lookahead(unsigned depth, std::chrono::milliseconds budget, unsigned width = 4);
+		void set_endgame(unsigned max_cells, size_t node_budget = endgame::DEFAULT_NODE_BUDGET,
+			std::chrono::milliseconds time_budget = std::chrono::milliseconds::zero());
+
+		void set_seed(std::uint64_t seed);
+		/**Returns the seed given to the last call to `set_seed`, or the random seed the solver started with.*/
+		std::uint64_t seed() const { return _seed; }
+
+		/**Returns the work done by the solver since it was made or `reset_stats` was last called.*/
+		const solver_stats& stats() const { return _stats; }
+		/**Sets every count and time of `stats` back to 0.*/
+		void reset_stats() { _stats.reset(); }
 	protected:
-		static std::mt19937 rng;
+		static constexpr unsigned DEFAULT_ENDGAME_CELLS = 20;
 
 		grid g;
 		region_set regions;
+		frontier components;
+		/**the number of bombs left, deduced from in `fill_global_queue` instead of as a region**/
+		global_constraint global;
+		probability_map probabilities;
+		/**the seed given to the last call to `set_seed`**/
+		std::uint64_t _seed;
+		/**chooses the first move and breaks ties between guesses**/
+		std::mt19937_64 rng;
+		/**not copied with the solver**/
+		solver_stats _stats;
 		bool regions_were_reset = false;
-		std::unordered_set<rc_coord, rc_coord_hash> safe_queue;
-		std::unordered_set<rc_coord, rc_coord_hash> bomb_queue;
+		/**cells known to be safe or bombs, ordered so the next move does not depend on how they were queued**/
+		std::set<rc_coord> safe_queue;
+		std::set<rc_coord> bomb_queue;
 		std::unordered_set<rc_coord, rc_coord_hash> modified_cells;
 
+		guess_mode guessing = PAYOUT_GUESS;
+		/**most guesses searched ahead by `plan_guess`**/
+		unsigned lookahead_depth = 2;
+		/**most candidate cells searched at each guess of `plan_guess`**/
+		unsigned lookahead_width = 4;
+		/**wall clock time `plan_guess` may spend on one move**/
+		std::chrono::milliseconds lookahead_budget{ 100 };
+		/**values of the positions searched by `plan_guess`, not copied with the solver**/
+		transposition_table transpositions;
+		std::chrono::steady_clock::time_point lookahead_deadline;
+		bool lookahead_timed_out = false;
+
+		/**most unopened cells for which `step` searches the endgame, 0 to never search it**/
+		unsigned endgame_cells = DEFAULT_ENDGAME_CELLS;
+		/**work the endgame search may spend on one move, see `endgame::solve`**/
+		size_t endgame_nodes = endgame::DEFAULT_NODE_BUDGET;
+		/**wall clock time the endgame search may spend on one move, 0 for no limit**/
+		std::chrono::milliseconds endgame_time_budget{ 0 };
+		/**not copied with the solver**/
+		endgame endgame_search;
+
+		/**the regions derived by one worker of `find_aux_regions`, and its scratch space**/
+		struct aux_buffer {
+			std::vector<region> candidates;
+			region_set::subset_type overlaps;
+			/**pairs compared and regions built by the last call, see `solver_stats`**/
+			size_t pairs = 0;
+			size_t built = 0;
+		};
+
+		/**fewest pending regions for which `find_aux_regions` splits the work between threads**/
+		static constexpr size_t PARALLEL_AUX_MIN = 64;
+		/**workers used by `find_aux_regions` and `expected_payouts`, shared with copies of the solver. Null when single threaded**/
+		std::shared_ptr<thread_pool> pool;
+		/**the solver each worker of `expected_payouts` evaluates outcomes on, kept between calls and not copied**/
+		std::vector<std::unique_ptr<solver>> payout_snapshots;
+
+		//scratch space for find_aux_regions, kept between calls so the loop does not allocate
+		std::vector<aux_buffer> aux_buffers;
+		region_set::subset_type aux_pending;
+		std::vector<std::pair<unsigned, region_set::handle>> aux_components;
+		/**the cells opened by the last call to `apply_open`, kept between calls so opening does not allocate**/
+		std::vector<rc_coord> opened_cells;
+
+		/**a change to the safe or bomb queue, recorded while a checkpoint is active**/
+		struct queue_change {
+			rc_coord cell;
+			bool bomb;
+			bool inserted;
+		};
+		/**state restored by `rollback` that is not kept in a trail**/
+		struct checkpoint_state {
+			size_t queue_trail_size;
+			std::unordered_set<rc_coord, rc_coord_hash> modified_cells;
+			bool regions_were_reset;
+		};
+		std::vector<queue_change> queue_trail;
+		std::vector<checkpoint_state> checkpoints;
+
+		void checkpoint();
+		void rollback();
+		void record_queue_change(rc_coord cell, bool bomb, bool inserted);
+
 		int remove_safe(rc_coord cell);
 		int remove_bomb(rc_coord cell);
+		int resolve_cells(const std::vector<rc_coord>& safe, const std::vector<rc_coord>& bombs);
 		rc_coord get_safe_from_queue() const;
 		rc_coord get_bomb_from_queue() const;
 
@@ -73,14 +196,34 @@ namespace ms {
 		int apply_flag(rc_coord cell);
 		int reset_regions();
 		
-		region approx_remain() const;
-		float expected_payout(rc_coord cell) const;
+		/**the cells that could be opened or flagged if a cell shows one number, and how likely it is to show it**/
+		struct payout_outcome {
+			float payout = 0;
+			float permutations = 0;
+		};
+
+		float expected_payout(rc_coord cell);
+		std::vector<float> expected_payouts(const std::vector<rc_coord>& cells);
+		void refresh_snapshot(solver& snapshot) const;
+		region payout_base(rc_coord cell, unsigned& flags) const;
+		payout_outcome assume_count(rc_coord cell, region base, unsigned flags, unsigned count, unsigned depth = 0);
+		static float combine_payouts(const payout_outcome* outcomes);
+
+		void compute_probabilities();
+		rc_coord plan_guess();
+		float lookahead(unsigned depth, rc_coord* best_move);
 
 		int find_regions();
 		int find_base_regions();
 		int find_aux_regions(bool lazy);
+		int find_component_aux_regions(bool lazy);
+		void add_base_region(const region& reg);
+		void add_region(const region& reg);
+		void derive_aux_regions(size_t begin, size_t end, aux_buffer& out) const;
+		void queue_aux_region(region&& candidate, aux_buffer& out) const;
 
 		int fill_queue();
+		int fill_global_queue();
 		int add_to_safe_queue(rc_coord to_add);
 		int add_to_bomb_queue(rc_coord to_add);
 
@@ -0,0 +1,92 @@
+#include "solver_stats.h"
+
+namespace ms {
+
+/**
+ * Adds the calls, times and counters of `other` to these.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+void solver_stats::merge(const solver_stats& other) {
+    for(unsigned p = 0; p < PHASE_COUNT; ++p) {
+        phases[p].calls += other.phases[p].calls;
+        phases[p].nanoseconds += other.phases[p].nanoseconds;
+    }
+    for(unsigned c = 0; c < COUNTER_COUNT; ++c)
+        counters[c] += other.counters[c];
+}
+
+/**
+ * Sets every call, time and counter back to 0.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+void solver_stats::reset() {
+    phases.fill(phase_totals());
+    counters.fill(0);
+}
+
+/**
+ * Returns the stats as one JSON object, with the calls and nanoseconds of each phase under
+ * `"phases"` and each counter under `"counters"`, keyed by `name`.
+ **/
+std::string solver_stats::to_json() const {
+    std::string ret = "{\"phases\":{";
+    for(unsigned p = 0; p < PHASE_COUNT; ++p) {
+        if(p > 0)
+            ret += ',';
+        ret += '"';
+        ret += name(phase(p));
+        ret += "\":{\"calls\":" + std::to_string(phases[p].calls) +
+            ",\"nanoseconds\":" + std::to_string(phases[p].nanoseconds) + '}';
+    }
+    ret += "},\"counters\":{";
+    for(unsigned c = 0; c < COUNTER_COUNT; ++c) {
+        if(c > 0)
+            ret += ',';
+        ret += '"';
+        ret += name(counter(c));
+        ret += "\":" + std::to_string(counters[c]);
+    }
+    ret += "}}";
+    return ret;
+}
+
+/**
+ * Returns the name of a phase, as used by `to_json`.
+ **/
+const char* solver_stats::name(phase p) {
+    switch(p) {
+    case FIND_BASE_REGIONS: return "find_base_regions";
+    case FIND_AUX_REGIONS: return "find_aux_regions";
+    case FILL_QUEUE: return "fill_queue";
+    case FILL_GLOBAL_QUEUE: return "fill_global_queue";
+    case PROBABILITIES: return "probabilities";
+    case EXPECTED_PAYOUT: return "expected_payout";
+    case LOOKAHEAD: return "lookahead";
+    case ENDGAME: return "endgame";
+    default: return "unknown";
+    }
+}
+
+/**
+ * Returns the name of a counter, as used by `to_json`.
+ **/
+const char* solver_stats::name(counter c) {
+    switch(c) {
+    case AUX_ITERATIONS: return "aux_iterations";
+    case AUX_PAIRS: return "aux_pairs";
+    case AUX_CANDIDATES: return "aux_candidates";
+    case AUX_CANDIDATES_KEPT: return "aux_candidates_kept";
+    case BASE_REGIONS: return "base_regions";
+    case REGIONS_ADDED: return "regions_added";
+    case REGIONS_MERGED: return "regions_merged";
+    case CELLS_QUEUED: return "cells_queued";
+    case SOLVER_COPIES: return "solver_copies";
+    case SNAPSHOT_REFRESHES: return "snapshot_refreshes";
+    case CHECKPOINTS: return "checkpoints";
+    default: return "unknown";
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef MS_SOLVER_STATS_H
+#define MS_SOLVER_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ms {
+
+/**
+ * Counts the work done by a `solver`: the calls to and time spent in each phase, and counters of
+ * the regions, candidates and copies made along the way.
+ *
+ * Only the thread that owns a solver updates its stats. Work done on other threads is counted in
+ * per-worker buffers or copies of the solver, and added in with `merge` once the workers are done.
+ * Phases nest, so the time of `FIND_AUX_REGIONS` includes the regions derived while estimating
+ * payouts, which is also part of the time of `EXPECTED_PAYOUT`.
+ **/
+class solver_stats {
+public:
+    enum phase {
+        /**regions read from the numbers around changed cells, `solver::find_base_regions`**/
+        FIND_BASE_REGIONS,
+        /**regions derived from overlapping regions, `solver::find_aux_regions`**/
+        FIND_AUX_REGIONS,
+        /**cells queued from determined regions, `solver::fill_queue`**/
+        FILL_QUEUE,
+        /**cells queued from the number of bombs left, `solver::fill_global_queue`**/
+        FILL_GLOBAL_QUEUE,
+        /**probabilities of every hidden cell, `probability_map::compute`**/
+        PROBABILITIES,
+        /**payouts of the guesses tied on probability, `solver::expected_payouts`**/
+        EXPECTED_PAYOUT,
+        /**guesses searched ahead, `solver::plan_guess`**/
+        LOOKAHEAD,
+        /**exhaustive searches of the last cells, `endgame::solve`**/
+        ENDGAME,
+        PHASE_COUNT
+    };
+
+    enum counter {
+        /**passes of `find_aux_regions` over the regions of one component**/
+        AUX_ITERATIONS,
+        /**pairs of overlapping regions compared by `find_aux_regions`**/
+        AUX_PAIRS,
+        /**regions built from the pairs**/
+        AUX_CANDIDATES,
+        /**built regions not already in the set with a range at least as tight**/
+        AUX_CANDIDATES_KEPT,
+        /**regions read from the grid by `find_base_regions`**/
+        BASE_REGIONS,
+        /**regions added to the set that covered a new area**/
+        REGIONS_ADDED,
+        /**regions that tightened the range of a region already in the set**/
+        REGIONS_MERGED,
+        /**cells added to the safe or bomb queue, including those of hypothetical moves**/
+        CELLS_QUEUED,
+        /**copies of the solver made for the workers of `expected_payouts`, once per worker**/
+        SOLVER_COPIES,
+        /**snapshots of the solver brought up to date for a worker of `expected_payouts`**/
+        SNAPSHOT_REFRESHES,
+        /**checkpoints taken to try a hypothetical move and roll it back**/
+        CHECKPOINTS,
+        COUNTER_COUNT
+    };
+
+    /**the calls to a phase and the time spent in them**/
+    struct phase_totals {
+        std::uint64_t calls = 0;
+        std::uint64_t nanoseconds = 0;
+    };
+
+    /**
+     * Adds the time from its construction to its destruction, and one call, to a phase.
+     **/
+    class timer {
+    public:
+        timer(solver_stats& stats, phase p) : totals(stats.phases[p]), start(clock::now()) {}
+        ~timer() {
+            ++totals.calls;
+            totals.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        }
+        timer(const timer&) = delete;
+        timer& operator=(const timer&) = delete;
+    private:
+        typedef std::chrono::steady_clock clock;
+        phase_totals& totals;
+        clock::time_point start;
+    };
+
+    /**Adds `n` to a counter.\n Complexity \f$O(1)\f$**/
+    void count(counter c, std::uint64_t n = 1) { counters[c] += n; }
+    /**Returns the value of a counter.\n Complexity \f$O(1)\f$**/
+    std::uint64_t get(counter c) const { return counters[c]; }
+    /**Returns the calls to and time spent in a phase.\n Complexity \f$O(1)\f$**/
+    const phase_totals& get(phase p) const { return phases[p]; }
+
+    void merge(const solver_stats& other);
+    void reset();
+    std::string to_json() const;
+
+    static const char* name(phase p);
+    static const char* name(counter c);
+
+private:
+    std::array<phase_totals, PHASE_COUNT> phases;
+    std::array<std::uint64_t, COUNTER_COUNT> counters{};
+};
+
+}
+
+#endif //MS_SOLVER_STATS_H
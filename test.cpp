@@ -1,7 +1,15 @@
 #define CATCH_CONFIG_MAIN
 #include "test/grid_test.h"
 #include "test/solver_test.h"
-#include "test/spingrid_test.h"
-#include "test/spinoff_test.h"
 #include "test/region_test.h"
 #include "test/region_set_test.h"
+#include "test/frontier_test.h"
+#include "test/global_constraint_test.h"
+#include "test/thread_pool_test.h"
+#include "test/probability_test.h"
+#include "test/transposition_table_test.h"
+#include "test/monte_carlo_test.h"
+#include "test/endgame_test.h"
+#include "test/game_runner_test.h"
+#include "test/solver_stats_test.h"
+#include "test/debug_test.h"
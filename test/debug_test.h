@@ -0,0 +1,40 @@
+#ifndef MS_TEST_DEBUG_TEST_H
+#define MS_TEST_DEBUG_TEST_H
+
+#include <catch.hpp>
+#include <sstream>
+#include <string>
+#include "../debug.h"
+
+TEST_CASE("debug: trace lines", "dbg::trace_line") {
+    dbg::trace_line line;
+    line << "opened: " << 12 << '\n';
+    CHECK(std::string(line.data(), line.size()) == "opened: 12\n");
+
+    //anything past the end of the buffer is dropped
+    line.reset();
+    line << std::string(dbg::MESSAGE_SIZE + 10, 'x');
+    CHECK(line.size() == dbg::MESSAGE_SIZE);
+    line.reset();
+    CHECK(line.size() == 0);
+    CHECK(line.good());
+}
+
+TEST_CASE("debug: traces are lazy and written in order", "MS_TRACE, dbg::trace, dbg::flush_trace") {
+    int evaluated = 0;
+    MS_TRACE(dbg::trace_level + 1, ++evaluated);
+    CHECK(evaluated == 0);
+
+    std::ostringstream out;
+    dbg::set_trace_output(&out);
+    dbg::trace("first ", 6);
+    dbg::trace("second", 6);
+    MS_TRACE(0, "[" << 3 << "]");
+    dbg::flush_trace();
+    dbg::set_trace_output(&std::cout);
+
+    CHECK(out.str() == "first second[3]");
+    CHECK(dbg::dropped_traces() == 0);
+}
+
+#endif //MS_TEST_DEBUG_TEST_H
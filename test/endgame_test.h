@@ -0,0 +1,89 @@
+#ifndef MS_TEST_ENDGAME_TEST_H
+#define MS_TEST_ENDGAME_TEST_H
+
+#include <catch.hpp>
+#include <chrono>
+#include "../endgame.h"
+
+TEST_CASE("endgame: exact chance of winning", "endgame::solve, endgame::win_probability") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    grid::cell *init[2];
+    init[0] = new grid::cell[2]{ _F,_0 };
+    init[1] = new grid::cell[2]{ _0,_0 };
+
+    endgame search;
+
+    SECTION("one number next to three cells") {
+        //each of the three layouts is as likely, and no cell tells the other two apart
+        grid testgrid(2,2,init);
+        testgrid.open(1,1);
+        REQUIRE(search.solve(testgrid, endgame::DEFAULT_NODE_BUDGET, deadline));
+        CHECK(search.layouts() == 3);
+        CHECK(search.win_probability() == Approx(1.0 / 3));
+        CHECK(testgrid.get(search.best_move().row, search.best_move().col) == grid::ms_hidden);
+    }
+
+    SECTION("two cells that can not be told apart") {
+        grid testgrid(2,2,init);
+        testgrid.open(1,0);
+        testgrid.open(1,1);
+        REQUIRE(search.solve(testgrid, endgame::DEFAULT_NODE_BUDGET, deadline));
+        CHECK(search.layouts() == 2);
+        CHECK(search.win_probability() == Approx(0.5));
+        CHECK(search.best_move().row == 0);
+    }
+
+    SECTION("only bombs left") {
+        grid testgrid(2,2,init);
+        testgrid.open(1,0);
+        testgrid.open(1,1);
+        testgrid.open(0,1);
+        CHECK_FALSE(search.solve(testgrid, endgame::DEFAULT_NODE_BUDGET, deadline));
+    }
+
+    SECTION("numbers no layout agrees with") {
+        grid testgrid(2,2,init);
+        testgrid.open(1,1);
+        testgrid.set_flag(0,0,grid::ms_flag);
+        testgrid.set_flag(1,0,grid::ms_flag);
+        CHECK_FALSE(search.solve(testgrid, endgame::DEFAULT_NODE_BUDGET, deadline));
+    }
+
+    for(int r = 0; r < 2; ++r)
+        delete[] init[r];
+}
+
+TEST_CASE("endgame: information from numbers", "endgame::solve, endgame::best_move") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    //the 1 at (0,2) has one bomb at (0,1) or (0,3), and the other bomb is at (0,0) or (0,4):
+    //opening an end cell is safe half the time and then shows where both bombs are
+    grid::cell *init[1];
+    init[0] = new grid::cell[5]{ _F,_0,_0,_F,_0 };
+    grid testgrid(1,5,init);
+    testgrid.open(0,2);
+
+    endgame search;
+    REQUIRE(search.solve(testgrid));
+    CHECK(search.layouts() == 4);
+    CHECK(search.win_probability() == Approx(0.5));
+    CHECK(search.positions() > 0);
+
+    //no time to search
+    CHECK_FALSE(search.solve(testgrid, endgame::DEFAULT_NODE_BUDGET, std::chrono::steady_clock::now() - std::chrono::seconds(1)));
+    //no work to search
+    CHECK_FALSE(search.solve(testgrid, 1));
+    CHECK(search.nodes_searched() > 1);
+
+    delete[] init[0];
+}
+
+#endif
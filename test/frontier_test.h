@@ -0,0 +1,50 @@
+#ifndef MS_TEST_FRONTIER_TEST_H
+#define MS_TEST_FRONTIER_TEST_H
+
+#include <catch.hpp>
+#include "../frontier.h"
+
+TEST_CASE("frontier: link and rebuild components", "frontier::link, frontier::build, frontier::find") {
+    using namespace ms;
+
+    frontier components(6,6);
+    region_set regions(6,6);
+
+    region left, middle, right;
+    left.add_cell(rc_coord{0,0});
+    left.add_cell(rc_coord{1,0});
+    left.set_count(1);
+    middle.add_cell(rc_coord{1,0});
+    middle.add_cell(rc_coord{2,1});
+    middle.set_count(1);
+    right.add_cell(rc_coord{0,5});
+    right.add_cell(rc_coord{1,5});
+    right.add_cell(rc_coord{2,5});
+    right.set_count(2);
+
+    CHECK_FALSE(components.connected(rc_coord{0,0}, rc_coord{1,0}));
+    CHECK(components.component_size(rc_coord{0,0}) == 1);
+
+    for(const region& reg : { left, middle, right }) {
+        components.link(reg);
+        regions.add(reg);
+    }
+    CHECK(components.connected(rc_coord{0,0}, rc_coord{2,1}));
+    CHECK(components.connected(rc_coord{0,5}, rc_coord{2,5}));
+    CHECK_FALSE(components.connected(rc_coord{0,0}, rc_coord{0,5}));
+    CHECK_FALSE(components.connected(rc_coord{0,0}, rc_coord{3,3}));
+    CHECK(components.component_size(rc_coord{1,0}) == 3);
+    CHECK(components.component_size(rc_coord{1,5}) == 3);
+
+    //components are only split when rebuilt
+    regions.remove_safe(rc_coord{1,0});
+    CHECK(components.connected(rc_coord{0,0}, rc_coord{2,1}));
+    components.build(regions);
+    CHECK_FALSE(components.connected(rc_coord{0,0}, rc_coord{2,1}));
+    CHECK(components.connected(rc_coord{0,5}, rc_coord{2,5}));
+
+    components.clear();
+    CHECK_FALSE(components.connected(rc_coord{0,5}, rc_coord{2,5}));
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef MS_TEST_GAME_RUNNER_TEST_H
+#define MS_TEST_GAME_RUNNER_TEST_H
+
+#include <catch.hpp>
+#include "../game_runner.h"
+
+TEST_CASE("game_runner: games are reproduced by their seeds", "game_runner::run, game_runner::play, game_runner::game_seed") {
+    using namespace ms;
+
+    const unsigned games = 12;
+    game_runner runner(9,9,10);
+    runner.set_threads(3);
+    CHECK(runner.threads() == 3);
+    std::vector<game_runner::game_result> parallel = runner.run(games, 42);
+    runner.set_threads(1);
+    std::vector<game_runner::game_result> serial = runner.run(games, 42);
+
+    REQUIRE(parallel.size() == games);
+    REQUIRE(serial.size() == games);
+    for(unsigned game = 0; game < games; ++game) {
+        INFO("game " << game);
+        CHECK(parallel[game].seed == game_runner::game_seed(42, game));
+        CHECK(parallel[game].seed == serial[game].seed);
+        CHECK((parallel[game].state == grid::WON || parallel[game].state == grid::LOST));
+        CHECK(parallel[game].state == serial[game].state);
+        CHECK(parallel[game].moves == serial[game].moves);
+        CHECK(parallel[game].guesses == serial[game].guesses);
+        CHECK(parallel[game].guesses >= 1);
+        CHECK(parallel[game].certain_latency.empty());
+    }
+
+    game_runner::game_result replayed = runner.play(parallel[5].seed);
+    CHECK(replayed.state == parallel[5].state);
+    CHECK(replayed.moves == parallel[5].moves);
+    CHECK(replayed.guesses == parallel[5].guesses);
+
+    runner.set_record_latency(true);
+    game_runner::game_result timed = runner.play(parallel[5].seed);
+    CHECK(timed.moves == parallel[5].moves);
+    CHECK(timed.guess_latency.size() >= timed.guesses);
+    CHECK_FALSE(timed.certain_latency.empty());
+}
+
+#endif //MS_TEST_GAME_RUNNER_TEST_H
@@ -0,0 +1,69 @@
+#ifndef MS_TEST_GLOBAL_CONSTRAINT_TEST_H
+#define MS_TEST_GLOBAL_CONSTRAINT_TEST_H
+
+#include <catch.hpp>
+#include "../global_constraint.h"
+
+TEST_CASE("global_constraint: deductions outside of disjoint regions", "global_constraint::deduce, global_constraint::covers") {
+    using namespace ms;
+
+    global_constraint global(4,4);
+    region_set regions(4,4);
+
+    region left, overlap, right;
+    left.add_cell(rc_coord{0,0});
+    left.add_cell(rc_coord{1,0});
+    left.set_count(1);
+    overlap.add_cell(rc_coord{1,0});
+    overlap.add_cell(rc_coord{2,0});
+    overlap.add_cell(rc_coord{3,0});
+    overlap.set_count(2);
+    right.add_cell(rc_coord{0,3});
+    right.add_cell(rc_coord{1,3});
+    right.add_cell(rc_coord{2,3});
+    right.set_range(1,2);
+    for(const region& reg : { left, overlap, right })
+        regions.add(reg);
+
+    SECTION("regions hold every bomb left") {
+        //overlap and right are disjoint and hold at least 3 bombs
+        global.set(10, 3);
+        REQUIRE(global.deduce(regions) == global_constraint::OUTSIDE_SAFE);
+        CHECK(global.family().size() == 2);
+        CHECK(global.covers(rc_coord{2,0}));
+        CHECK(global.covers(rc_coord{1,3}));
+        CHECK_FALSE(global.covers(rc_coord{0,0}));
+        CHECK_FALSE(global.covers(rc_coord{2,2}));
+    }
+
+    SECTION("regions hold every safe cell left") {
+        //left and right are disjoint and hold at least 2 safe cells, overlap only shares a cell with left
+        global.set(6, 4);
+        REQUIRE(global.deduce(regions) == global_constraint::OUTSIDE_BOMBS);
+        CHECK(global.covers(rc_coord{0,0}));
+        CHECK(global.covers(rc_coord{0,3}));
+        CHECK_FALSE(global.covers(rc_coord{3,0}));
+    }
+
+    SECTION("nothing known") {
+        global.set(12, 5);
+        CHECK(global.deduce(regions) == global_constraint::NONE);
+        CHECK(global.family().empty());
+        CHECK_FALSE(global.covers(rc_coord{2,0}));
+    }
+
+    SECTION("no bombs or no safe cells left") {
+        global.set(5, 0);
+        CHECK(global.deduce(regions) == global_constraint::OUTSIDE_SAFE);
+        global.set(5, 5);
+        CHECK(global.deduce(regions) == global_constraint::OUTSIDE_BOMBS);
+        CHECK_FALSE(global.covers(rc_coord{0,0}));
+    }
+
+    SECTION("regions need more bombs than are left") {
+        global.set(10, 2);
+        CHECK_THROWS_AS(global.deduce(regions), bad_region_error);
+    }
+}
+
+#endif //MS_TEST_GLOBAL_CONSTRAINT_TEST_H
@@ -85,6 +85,27 @@ TEST_CASE("grid: cell access", "grid::open, grid::get") {
     CHECK(testgrid.get(7,1) == grid::cell::ms_bomb);
 }
 
+TEST_CASE("grid: open into a buffer", "grid::open") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[4];
+    init[0] = new grid::cell[4]{ _F,_0,_0,_0 };
+    init[1] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[2] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[3] = new grid::cell[4]{ _0,_0,_0,_F };
+
+    grid testgrid(4,4,init);
+    std::vector<rc_coord> opened = { rc_coord(3,3) };
+    testgrid.open(0,3,opened);
+    CHECK(opened.size() == 14);
+    CHECK(opened.front() == rc_coord(0,3));
+    testgrid.open(0,3,opened);
+    CHECK(opened.empty());
+}
+
 TEST_CASE("grid: flag", "grid::flag, grid::set_flag, grid::get") {
     using namespace ms;
 
@@ -123,6 +144,202 @@ TEST_CASE("grid: flag", "grid::flag, grid::set_flag, grid::get") {
     CHECK(testgrid.get(6,6) == grid::cell::ms_question);
 }
 
+TEST_CASE("grid: checkpoint and rollback", "grid::checkpoint, grid::rollback, grid::assume") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[4];
+    init[0] = new grid::cell[4]{ _F,_0,_0,_0 };
+    init[1] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[2] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[3] = new grid::cell[4]{ _0,_0,_0,_F };
+
+    grid testgrid(4,4,init);
+    CHECK_THROWS_AS(testgrid.assume(1,1,grid::cell::ms_1), grid_error);
+    testgrid.open(0,1);
+    grid before(testgrid, grid::SURFACE_COPY);
+    int unopened = testgrid.count_unopened();
+
+    testgrid.checkpoint();
+    CHECK(testgrid.open(1,0).size() == 1);
+    testgrid.flag(0,0);
+    testgrid.checkpoint();
+    CHECK(testgrid.assume(3,3,grid::cell::ms_2) == 0);
+    CHECK(testgrid.get(3,3) == grid::cell::ms_2);
+    CHECK(testgrid.assume(0,1,grid::cell::ms_2) == 1);
+    testgrid.rollback();
+    CHECK(testgrid.get(3,3) == grid::cell::ms_hidden);
+    CHECK(testgrid.get(0,0) == grid::cell::ms_flag);
+    testgrid.rollback();
+
+    CHECK(testgrid.checkpoint_depth() == 0);
+    CHECK(testgrid.count_unopened() == unopened);
+    CHECK(testgrid.count_flags() == 0);
+    CHECK(testgrid.gamestate() == grid::RUNNING);
+    for(unsigned r = 0; r < 4; ++r) {
+        for(unsigned c = 0; c < 4; ++c) {
+            INFO("coordinates: [" << r << "][" << c << "]");
+            CHECK(testgrid.get(r,c) == before.get(r,c));
+        }
+    }
+}
+
+TEST_CASE("grid: hash of the visible grid", "grid::hash") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[3];
+    init[0] = new grid::cell[3]{ _F,_0,_0 };
+    init[1] = new grid::cell[3]{ _0,_0,_0 };
+    init[2] = new grid::cell[3]{ _0,_0,_F };
+
+    grid first(3,3,init), second(3,3,init);
+    CHECK(first.hash() == 0);
+
+    first.flag(0,0);
+    first.open(0,1);
+    std::uint64_t opened = first.hash();
+    CHECK(opened != 0);
+    second.open(0,1);
+    CHECK(second.hash() != opened);
+    second.flag(0,0);
+    CHECK(second.hash() == opened);
+    CHECK(grid(second, grid::SURFACE_COPY).hash() == opened);
+
+    second.checkpoint();
+    second.assume(1,1,grid::cell::ms_2);
+    CHECK(second.hash() != opened);
+    second.rollback();
+    CHECK(second.hash() == opened);
+
+    second.flag(0,0);
+    second.flag(0,0);
+    second.flag(0,0);
+    CHECK(second.hash() == opened);
+}
+
+TEST_CASE("grid: linear indices and neighbors", "grid::index, grid::coord, grid::get_at, grid::neighbor_offsets") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[2];
+    init[0] = new grid::cell[3]{ _F,_0,_0 };
+    init[1] = new grid::cell[3]{ _0,_0,_0 };
+
+    grid testgrid(2,3,init);
+    testgrid.open(1,2);
+
+    for(unsigned r = 0; r < 2; ++r) {
+        for(unsigned c = 0; c < 3; ++c) {
+            INFO("coordinates: [" << r << "][" << c << "]");
+            unsigned index = testgrid.index(r,c);
+            CHECK(testgrid.coord(index) == rc_coord(r,c));
+            CHECK(testgrid.get_at(index) == testgrid.get(r,c));
+
+            //neighbors past the edge of the grid show ms_error
+            unsigned contained = 0;
+            for(int offset : testgrid.neighbor_offsets()) {
+                if(testgrid.get_at(index + offset) != grid::ms_error) {
+                    ++contained;
+                    rc_coord neighbor = testgrid.coord(index + offset);
+                    CHECK(testgrid.iscontained(neighbor.row, neighbor.col));
+                    CHECK(std::abs(int(neighbor.row) - int(r)) <= 1);
+                    CHECK(std::abs(int(neighbor.col) - int(c)) <= 1);
+                }
+            }
+            CHECK(contained == (c == 1 ? 5u : 3u));
+        }
+    }
+
+    grid copy(testgrid, grid::FULL_COPY);
+    CHECK(copy.get(0,1) == grid::ms_1);
+    copy.flag(0,0);
+    CHECK(copy.get(0,0) == grid::ms_flag);
+    CHECK(testgrid.get(0,0) == grid::ms_hidden);
+
+    for(int r = 0; r < 2; ++r)
+        delete[] init[r];
+}
+
+TEST_CASE("grid: unopened cells and winning", "grid::next_unopened, grid::count_unopened, grid::open") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[3];
+    init[0] = new grid::cell[3]{ _F,_0,_0 };
+    init[1] = new grid::cell[3]{ _0,_0,_0 };
+    init[2] = new grid::cell[3]{ _0,_0,_F };
+
+    grid testgrid(3,3,init);
+    auto unopened = [&testgrid]() {
+        std::vector<rc_coord> ret;
+        for(unsigned i = testgrid.next_unopened(0); i < testgrid.index_end(); i = testgrid.next_unopened(i + 1))
+            ret.push_back(testgrid.coord(i));
+        return ret;
+    };
+    CHECK(unopened().size() == 9);
+
+    testgrid.open(0,1);
+    testgrid.flag(0,0);
+    CHECK(testgrid.count_unopened() == 7);
+    CHECK(unopened().size() == 8);
+    CHECK(unopened().front() == rc_coord(0,0));
+
+    testgrid.checkpoint();
+    testgrid.assume(1,1,grid::ms_2);
+    CHECK(testgrid.count_unopened() == 6);
+    testgrid.rollback();
+    CHECK(unopened().size() == 8);
+
+    for(rc_coord cell : { rc_coord(0,2), rc_coord(1,0), rc_coord(1,1), rc_coord(1,2) }) {
+        testgrid.open(cell.row, cell.col);
+        CHECK(testgrid.gamestate() == grid::RUNNING);
+    }
+    //opens (2,1) as well
+    testgrid.open(2,0);
+    CHECK(testgrid.gamestate() == grid::WON);
+    CHECK(unopened() == std::vector<rc_coord>({ rc_coord(0,0), rc_coord(2,2) }));
+    CHECK(testgrid.get(2,2) == grid::ms_flag);
+
+    for(int r = 0; r < 3; ++r)
+        delete[] init[r];
+}
+
+TEST_CASE("grid: seeded bomb placement", "grid::set_seed, grid::seed") {
+    using namespace ms;
+
+    grid first(8,8,10), second(8,8,10);
+    first.set_seed(7);
+    second.set_seed(7);
+    CHECK(second.seed() == 7);
+
+    //the same seed and moves give the same game
+    for(unsigned r = 0; r < 8; ++r) {
+        for(unsigned c = 0; c < 8; ++c) {
+            first.open(r,c);
+            second.open(r,c);
+        }
+    }
+    CHECK(first.gamestate() == second.gamestate());
+    for(unsigned r = 0; r < 8; ++r) {
+        for(unsigned c = 0; c < 8; ++c) {
+            INFO("coordinates: [" << r << "][" << c << "]");
+            CHECK(first.get(r,c) == second.get(r,c));
+        }
+    }
+    //the seed moves on for the next game
+    CHECK(second.seed() != 7);
+    CHECK(grid(second, grid::FULL_COPY).seed() == second.seed());
+}
+
     // TODO grid::reset();
 
 
@@ -0,0 +1,89 @@
+#ifndef MS_TEST_MONTE_CARLO_TEST_H
+#define MS_TEST_MONTE_CARLO_TEST_H
+
+#include <catch.hpp>
+#include <chrono>
+#include "../monte_carlo.h"
+#include "../probability.h"
+
+TEST_CASE("monte_carlo: sampled probabilities", "monte_carlo::sample, monte_carlo::get, monte_carlo::interval") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[4];
+    init[0] = new grid::cell[4]{ _F,_0,_0,_0 };
+    init[1] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[2] = new grid::cell[4]{ _0,_0,_F,_0 };
+    init[3] = new grid::cell[4]{ _0,_0,_0,_F };
+    grid testgrid(4,4,init);
+
+    //two overlapping regions of one bomb each, with two bombs left for the 11 other cells
+    region_set regions(4,4);
+    region a, b;
+    a.add_cell(rc_coord{0,0});
+    a.add_cell(rc_coord{0,1});
+    a.add_cell(rc_coord{0,2});
+    a.set_count(1);
+    b.add_cell(rc_coord{0,2});
+    b.add_cell(rc_coord{0,3});
+    b.add_cell(rc_coord{1,3});
+    b.set_count(1);
+    regions.add(a);
+    regions.add(b);
+
+    frontier components(4,4);
+    probability_map exact(4,4);
+    exact.compute(testgrid, regions, components);
+    REQUIRE(exact.is_exact());
+
+    monte_carlo sampler(4,4);
+    sampler.set_seed(7);
+    sampler.set_precision(0.01f);
+    sampler.set_time_budget(std::chrono::milliseconds(10000));
+    REQUIRE(sampler.sample(testgrid, regions));
+    CHECK(sampler.converged());
+    CHECK(sampler.samples() > 0);
+    for(unsigned r = 0; r < 4; ++r) {
+        for(unsigned c = 0; c < 4; ++c) {
+            INFO("coordinates: [" << r << "][" << c << "]");
+            CHECK(sampler.interval(rc_coord{r,c}) <= 0.01f);
+            CHECK(sampler.get(rc_coord{r,c}) == Approx(exact.get(rc_coord{r,c})).margin(0.02));
+        }
+    }
+    CHECK(sampler.unconstrained() == Approx(exact.unconstrained()).margin(0.02));
+
+    SECTION("the same seed gives the same results on any number of threads") {
+        thread_pool pool(3);
+        monte_carlo parallel(4,4);
+        parallel.set_seed(7);
+        parallel.set_precision(0.01f);
+        parallel.set_time_budget(std::chrono::milliseconds(10000));
+        REQUIRE(parallel.sample(testgrid, regions, &pool));
+        CHECK(parallel.samples() == sampler.samples());
+        for(unsigned r = 0; r < 4; ++r) {
+            for(unsigned c = 0; c < 4; ++c)
+                CHECK(parallel.get(rc_coord{r,c}) == sampler.get(rc_coord{r,c}));
+        }
+    }
+
+    SECTION("regions that can not be met are not sampled") {
+        region c;
+        c.add_cell(rc_coord{0,1});
+        c.set_count(1);
+        region d;
+        d.add_cell(rc_coord{0,2});
+        d.set_count(1);
+        regions.add(c);
+        regions.add(d);
+        CHECK_FALSE(sampler.sample(testgrid, regions));
+        CHECK_FALSE(sampler.converged());
+        CHECK(sampler.samples() == 0);
+    }
+
+    for(int r = 0; r < 4; ++r)
+        delete[] init[r];
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef MS_TEST_PROBABILITY_TEST_H
+#define MS_TEST_PROBABILITY_TEST_H
+
+#include <catch.hpp>
+#include <chrono>
+#include "../probability.h"
+
+TEST_CASE("probability_map: exact probabilities", "probability_map::compute, probability_map::get") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[3];
+    init[0] = new grid::cell[4]{ _F,_0,_0,_0 };
+    init[1] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[2] = new grid::cell[4]{ _0,_0,_0,_F };
+    grid testgrid(3,4,init);
+
+    region_set regions(3,4);
+    frontier components(3,4);
+    probability_map probabilities(3,4);
+
+    //no regions: every cell is equally likely
+    probabilities.compute(testgrid, regions, components);
+    CHECK(probabilities.is_exact());
+    CHECK(probabilities.unconstrained() == Approx(2.0 / 12));
+    CHECK(probabilities.get(rc_coord{1,1}) == Approx(2.0 / 12));
+
+    //a region of two cells with at most one bomb, ten cells left outside:
+    //no bomb in the region can be completed in C(10,2) = 45 ways, one bomb in 2 * C(10,1) = 20 ways
+    region pair;
+    pair.add_cell(rc_coord{0,0});
+    pair.add_cell(rc_coord{0,1});
+    pair.set_range(0,1);
+    regions.add(pair);
+    probabilities.compute(testgrid, regions, components);
+    CHECK(probabilities.is_exact());
+    CHECK(probabilities.get(rc_coord{0,0}) == Approx(10.0 / 65));
+    CHECK(probabilities.get(rc_coord{0,1}) == Approx(10.0 / 65));
+    CHECK(probabilities.unconstrained() == Approx(110.0 / 65 / 10));
+    CHECK(probabilities.get(rc_coord{2,2}) == Approx(110.0 / 65 / 10));
+
+    for(int r = 0; r < 3; ++r)
+        delete[] init[r];
+}
+
+TEST_CASE("probability_map: components and opened cells", "probability_map::compute") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[3];
+    init[0] = new grid::cell[5]{ _F,_0,_0,_0,_0 };
+    init[1] = new grid::cell[5]{ _0,_0,_0,_0,_0 };
+    init[2] = new grid::cell[5]{ _0,_0,_0,_0,_F };
+    grid testgrid(3,5,init);
+    testgrid.open(1,1);
+    testgrid.open(1,3);
+    testgrid.set_flag(2,4,grid::ms_flag);
+
+    region_set regions(3,5);
+    frontier components(3,5);
+    probability_map probabilities(3,5);
+
+    //(1,1) shows 1 and (1,3) shows 1 next to the flag at (2,4)
+    region left, right;
+    for(unsigned r = 0; r < 3; ++r) {
+        for(unsigned c = 0; c < 3; ++c) {
+            if(testgrid.get(r,c) == grid::ms_hidden)
+                left.add_cell(rc_coord{r,c});
+        }
+    }
+    left.set_count(1);
+    right.add_cell(rc_coord{0,4});
+    right.add_cell(rc_coord{1,4});
+    right.set_count(0);
+    regions.add(left);
+    regions.add(right);
+
+    probabilities.compute(testgrid, regions, components);
+    CHECK(probabilities.is_exact());
+    CHECK(probabilities.get(rc_coord{1,1}) == 0);
+    CHECK(probabilities.get(rc_coord{2,4}) == 1);
+    CHECK(probabilities.get(rc_coord{0,4}) == 0);
+    CHECK(probabilities.get(rc_coord{0,0}) == Approx(1.0 / left.size()));
+    //the only bomb left is in `left`
+    CHECK(probabilities.unconstrained() == 0);
+    CHECK(probabilities.get(rc_coord{0,3}) == 0);
+
+    //without a budget the component is estimated from its regions
+    probabilities.set_node_budget(0);
+    probabilities.compute(testgrid, regions, components);
+    CHECK_FALSE(probabilities.is_exact());
+    CHECK(probabilities.get(rc_coord{0,0}) == Approx(1.0 / left.size()));
+
+    for(int r = 0; r < 3; ++r)
+        delete[] init[r];
+}
+
+TEST_CASE("probability_map: sampled when out of nodes", "probability_map::compute, probability_map::set_node_budget, probability_map::set_sampling") {
+    using namespace ms;
+
+    const grid::cell _F = grid::cell::ms_bomb;
+    const grid::cell _0 = grid::cell::ms_0;
+
+    grid::cell *init[4];
+    init[0] = new grid::cell[4]{ _F,_0,_0,_0 };
+    init[1] = new grid::cell[4]{ _0,_0,_0,_0 };
+    init[2] = new grid::cell[4]{ _0,_0,_F,_0 };
+    init[3] = new grid::cell[4]{ _0,_0,_0,_F };
+    grid testgrid(4,4,init);
+
+    region_set regions(4,4);
+    region a, b;
+    a.add_cell(rc_coord{0,0});
+    a.add_cell(rc_coord{0,1});
+    a.add_cell(rc_coord{0,2});
+    a.set_count(1);
+    b.add_cell(rc_coord{0,2});
+    b.add_cell(rc_coord{0,3});
+    b.add_cell(rc_coord{1,3});
+    b.set_count(1);
+    regions.add(a);
+    regions.add(b);
+
+    frontier components(4,4);
+    probability_map exact(4,4);
+    exact.compute(testgrid, regions, components);
+    REQUIRE(exact.is_exact());
+
+    probability_map probabilities(4,4);
+    probabilities.set_node_budget(1);
+    probabilities.compute(testgrid, regions, components);
+    CHECK_FALSE(probabilities.is_exact());
+    CHECK_FALSE(probabilities.is_sampled());
+
+    probabilities.set_sampling(true);
+    probabilities.get_sampler().set_seed(7);
+    probabilities.get_sampler().set_precision(0.01f);
+    probabilities.get_sampler().set_time_budget(std::chrono::milliseconds(10000));
+    probabilities.compute(testgrid, regions, components);
+    CHECK_FALSE(probabilities.is_exact());
+    REQUIRE(probabilities.is_sampled());
+    for(unsigned r = 0; r < 4; ++r) {
+        for(unsigned c = 0; c < 4; ++c) {
+            INFO("coordinates: [" << r << "][" << c << "]");
+            CHECK(probabilities.get(rc_coord{r,c}) == probabilities.get_sampler().get(rc_coord{r,c}));
+            CHECK(probabilities.get(rc_coord{r,c}) == Approx(exact.get(rc_coord{r,c})).margin(0.02));
+            CHECK(probabilities.interval(rc_coord{r,c}) <= 0.01f);
+        }
+    }
+
+    for(int r = 0; r < 4; ++r)
+        delete[] init[r];
+}
+
+#endif
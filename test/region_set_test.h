@@ -2,5 +2,323 @@
 #define MS_TEST_REGION_SET_TEST_H
 
 #include <catch.hpp>
+#include "../region_set.h"
 
-#endif
\ No newline at end of file
+TEST_CASE("region_set: add, merge and remove", "region_set::add, region_set::remove, region_set::regions_intersecting") {
+    using namespace ms;
+
+    region_set regions(5,5);
+
+    region r1, r2, r1_tight;
+    r1.add_cell(rc_coord{1,1});
+    r1.add_cell(rc_coord{1,2});
+    r1.add_cell(rc_coord{2,2});
+    r1.set_range(0,2);
+    r1_tight = r1;
+    r1_tight.set_range(1,2);
+
+    r2.add_cell(rc_coord{2,2});
+    r2.add_cell(rc_coord{3,3});
+    r2.set_count(1);
+
+    auto added1 = regions.add(r1);
+    auto added2 = regions.add(r2);
+    CHECK(added1.second);
+    CHECK(added2.second);
+    CHECK(regions.size() == 2);
+    CHECK(regions[added1.first] == r1);
+
+    //same area merges into the existing region and keeps its handle
+    auto merged = regions.add(r1_tight);
+    CHECK(merged.first == added1.first);
+    CHECK(merged.second);
+    CHECK(regions.size() == 2);
+    CHECK(regions[added1.first].min() == 1);
+    CHECK_FALSE(regions.add(r1).second);
+
+    CHECK(regions.regions_intersecting(rc_coord{2,2}).size() == 2);
+    CHECK(regions.regions_intersecting(rc_coord{1,1}).size() == 1);
+    CHECK(regions.regions_intersecting(r2).size() == 2);
+
+    //handles are invalidated on removal and not reused by new regions
+    regions.remove(added1.first);
+    CHECK_FALSE(regions.is_valid(added1.first));
+    CHECK(regions.is_valid(added2.first));
+    CHECK(regions.size() == 1);
+    CHECK(regions.regions_intersecting(rc_coord{1,1}).empty());
+    auto readded = regions.add(r1);
+    CHECK(readded.first != added1.first);
+    CHECK_FALSE(regions.is_valid(added1.first));
+}
+
+TEST_CASE("region_set: copy and remove cells", "region_set::region_set, region_set::remove_safe, region_set::remove_bomb") {
+    using namespace ms;
+
+    region_set regions(5,5);
+
+    region r1;
+    r1.add_cell(rc_coord{0,0});
+    r1.add_cell(rc_coord{0,1});
+    r1.add_cell(rc_coord{1,1});
+    r1.set_count(2);
+    region_set::handle h = regions.add(r1).first;
+
+    region_set copy = regions;
+    CHECK(copy.get_modified_regions().size() == 1);
+
+    CHECK(copy.remove_bomb(rc_coord{0,0}) == 1);
+    CHECK(copy.remove_safe(rc_coord{0,1}) == 1);
+    CHECK(copy.size() == 1);
+    const region& left = *copy.begin();
+    CHECK(left.size() == 1);
+    CHECK(left.min() == 1);
+    CHECK(left.contains(rc_coord{1,1}));
+
+    //the original is not affected
+    CHECK(regions[h] == r1);
+    CHECK(regions.regions_intersecting(rc_coord{0,0}).size() == 1);
+    CHECK(copy.regions_intersecting(rc_coord{0,0}).empty());
+}
+
+TEST_CASE("region_set: find by area", "region_set::find") {
+    using namespace ms;
+
+    region_set regions(40,40);
+    std::vector<region> added;
+
+    //enough regions to grow the hash table a few times
+    for(unsigned r = 0; r + 1 < 40; r += 2) {
+        for(unsigned c = 0; c + 1 < 40; c += 3) {
+            region reg;
+            reg.add_cell(rc_coord{r,c});
+            reg.add_cell(rc_coord{r + 1,c + 1});
+            reg.set_count(1);
+            regions.add(reg);
+            added.push_back(reg);
+        }
+    }
+    CHECK(regions.size() == added.size());
+    for(const region& reg : added) {
+        region_set::handle h = regions.find(reg);
+        REQUIRE(h != region_set::NO_REGION);
+        CHECK(regions[h] == reg);
+    }
+
+    //remove every other region and check the rest can still be found
+    for(size_t i = 0; i < added.size(); i += 2) {
+        regions.remove(regions.find(added[i]));
+    }
+    for(size_t i = 0; i < added.size(); ++i) {
+        CHECK((regions.find(added[i]) == region_set::NO_REGION) == (i % 2 == 0));
+    }
+
+    region other;
+    other.add_cell(rc_coord{0,1});
+    CHECK(regions.find(other) == region_set::NO_REGION);
+}
+
+TEST_CASE("region_set: in place cell removal", "region_set::remove_safe, region_set::remove_bomb") {
+    using namespace ms;
+
+    region_set regions(5,5);
+
+    region wide_range, exact;
+    wide_range.add_cell(rc_coord{1,1});
+    wide_range.add_cell(rc_coord{1,2});
+    wide_range.add_cell(rc_coord{1,3});
+    wide_range.set_range(1,2);
+    exact.add_cell(rc_coord{1,2});
+    exact.add_cell(rc_coord{1,3});
+    exact.add_cell(rc_coord{2,3});
+    exact.set_count(1);
+
+    region_set::handle h1 = regions.add(wide_range).first;
+    region_set::handle h2 = regions.add(exact).first;
+    regions.reset_modified_regions();
+
+    //removing a cell that only one region has keeps its handle
+    CHECK(regions.remove_safe(rc_coord{2,3}) == 1);
+    CHECK(regions.is_valid(h2));
+    CHECK(regions[h2].size() == 2);
+    CHECK(regions.is_modified(h2));
+    CHECK(regions.regions_intersecting(rc_coord{1,2}).size() == 2);
+
+    //both regions now cover {(1,2),(1,3)} and are merged
+    CHECK(regions.remove_bomb(rc_coord{1,1}) == 1);
+    CHECK(regions.size() == 1);
+    CHECK(regions.is_valid(h1) != regions.is_valid(h2));
+    const region& merged = *regions.begin();
+    CHECK(merged.size() == 2);
+    CHECK(merged.min() == 1);
+    CHECK(merged.max() == 1);
+    CHECK(regions.regions_intersecting(rc_coord{1,3}).size() == 1);
+    CHECK(regions.regions_intersecting(rc_coord{1,1}).empty());
+
+    //a region that is no longer helpful is dropped
+    CHECK(regions.remove_bomb(rc_coord{1,2}) == 1);
+    CHECK(regions.size() == 1);
+    CHECK(regions.begin()->max() == 0);
+    CHECK(regions.remove_safe(rc_coord{1,3}) == 1);
+    CHECK(regions.empty());
+    CHECK(regions.regions_intersecting(rc_coord{1,3}).empty());
+}
+
+TEST_CASE("region_set: batched cell resolution", "region_set::resolve_cells") {
+    using namespace ms;
+
+    region_set regions(5,5), single(5,5);
+
+    region r1, r2, r3;
+    r1.add_cell(rc_coord{0,0});
+    r1.add_cell(rc_coord{0,1});
+    r1.add_cell(rc_coord{0,2});
+    r1.add_cell(rc_coord{1,2});
+    r1.set_range(1,2);
+    r2.add_cell(rc_coord{0,1});
+    r2.add_cell(rc_coord{1,1});
+    r2.add_cell(rc_coord{1,2});
+    r2.set_count(1);
+    r3.add_cell(rc_coord{3,3});
+    r3.add_cell(rc_coord{3,4});
+    r3.set_count(1);
+    for(const region& reg : { r1, r2, r3 }) {
+        regions.add(reg);
+        single.add(reg);
+    }
+    regions.reset_modified_regions();
+
+    std::vector<rc_coord> safe = { rc_coord{0,0}, rc_coord{1,1} };
+    std::vector<rc_coord> bombs = { rc_coord{0,2} };
+    CHECK(regions.resolve_cells(safe, bombs) == 2);
+    for(rc_coord cell : safe)
+        single.remove_safe(cell);
+    for(rc_coord cell : bombs)
+        single.remove_bomb(cell);
+
+    //same result as removing the cells one at a time
+    CHECK(regions.size() == single.size());
+    for(const region& reg : single) {
+        region_set::handle h = regions.find(reg);
+        REQUIRE(h != region_set::NO_REGION);
+        CHECK(regions[h] == reg);
+    }
+    //r1 and r2 both end up as {(0,1),(1,2)} and are merged, r3 is untouched
+    CHECK(regions.size() == 2);
+    CHECK(regions.get_modified_regions().size() == 1);
+    CHECK(regions.regions_intersecting(rc_coord{0,0}).empty());
+    CHECK(regions.regions_intersecting(rc_coord{0,1}).size() == 1);
+
+    //a region that cannot lose its cells is removed, the others are still updated
+    std::vector<rc_coord> impossible = { rc_coord{3,3}, rc_coord{3,4}, rc_coord{1,2} };
+    CHECK_THROWS_AS(regions.resolve_cells(impossible, {}), bad_region_error);
+    CHECK(regions.size() == 1);
+    CHECK(regions.begin()->size() == 1);
+    CHECK(regions.begin()->min() == 1);
+    CHECK(regions.regions_intersecting(rc_coord{3,3}).empty());
+}
+
+TEST_CASE("region_set: determined regions", "region_set::get_determined_regions, region_set::reset_determined_regions") {
+    using namespace ms;
+
+    region_set regions(5,5);
+
+    region undetermined, bombs;
+    undetermined.add_cell(rc_coord{0,0});
+    undetermined.add_cell(rc_coord{0,1});
+    undetermined.add_cell(rc_coord{0,2});
+    undetermined.set_count(1);
+    bombs.add_cell(rc_coord{2,2});
+    bombs.add_cell(rc_coord{2,3});
+    bombs.set_count(2);
+
+    region_set::handle hu = regions.add(undetermined).first;
+    region_set::handle hb = regions.add(bombs).first;
+    REQUIRE(regions.get_determined_regions().size() == 1);
+    CHECK(regions.get_determined_regions().front() == hb);
+    regions.reset_determined_regions();
+
+    //changes to a region that was already reported are not reported again
+    regions.remove_bomb(rc_coord{2,2});
+    CHECK(regions.get_determined_regions().empty());
+
+    //a region becomes determined when its last bomb is removed
+    regions.remove_bomb(rc_coord{0,0});
+    REQUIRE(regions.get_determined_regions().size() == 1);
+    CHECK(regions.get_determined_regions().front() == hu);
+    CHECK(regions[hu].max() == 0);
+    regions.reset_determined_regions();
+
+    //and when a merge tightens its range
+    region wide_range;
+    wide_range.add_cell(rc_coord{4,0});
+    wide_range.add_cell(rc_coord{4,1});
+    wide_range.set_range(1,2);
+    region_set::handle hw = regions.add(wide_range).first;
+    CHECK(regions.get_determined_regions().empty());
+    wide_range.set_range(2,2);
+    regions.add(wide_range);
+    REQUIRE(regions.get_determined_regions().size() == 1);
+    CHECK(regions.get_determined_regions().front() == hw);
+
+    regions.clear();
+    CHECK(regions.get_determined_regions().empty());
+}
+
+TEST_CASE("region_set: checkpoint and rollback", "region_set::checkpoint, region_set::rollback") {
+    using namespace ms;
+
+    region_set regions(6,6);
+
+    region r1, r2, r3;
+    r1.add_cell(rc_coord{0,0});
+    r1.add_cell(rc_coord{0,1});
+    r1.add_cell(rc_coord{1,1});
+    r1.set_range(1,2);
+    r2.add_cell(rc_coord{1,1});
+    r2.add_cell(rc_coord{2,2});
+    r2.set_count(1);
+    r3.add_cell(rc_coord{4,4});
+    r3.add_cell(rc_coord{4,5});
+    r3.set_count(1);
+    region_set::handle h1 = regions.add(r1).first;
+    region_set::handle h2 = regions.add(r2).first;
+    regions.reset_modified_regions();
+    regions.reset_determined_regions();
+    regions.add(r3);
+
+    std::vector<region> before(regions.begin(), regions.end());
+    region_set::subset_type modified = regions.get_modified_regions();
+
+    regions.checkpoint();
+    regions.remove_safe(rc_coord{1,1});
+    regions.remove(h2);
+    regions.resolve_cells({ rc_coord{4,4} }, {});
+    regions.checkpoint();
+    for(unsigned c = 0; c < 6; ++c) {
+        region extra;
+        extra.add_cell(rc_coord{5,c});
+        extra.set_count(1);
+        regions.add(extra);
+    }
+    regions.rollback();
+    CHECK(regions.size() == 2);
+    regions.clear();
+    regions.rollback();
+
+    CHECK(regions.checkpoint_depth() == 0);
+    CHECK(regions.is_valid(h1));
+    CHECK(regions.is_valid(h2));
+    CHECK(regions[h1] == r1);
+    CHECK(regions[h2] == r2);
+    CHECK(regions.get_modified_regions() == modified);
+    CHECK(regions.get_determined_regions().empty());
+    CHECK(std::vector<region>(regions.begin(), regions.end()) == before);
+    for(const region& reg : before) {
+        CHECK(regions.find(reg) != region_set::NO_REGION);
+    }
+    CHECK(regions.regions_intersecting(rc_coord{1,1}).size() == 2);
+    CHECK(regions.regions_intersecting(rc_coord{4,4}).size() == 1);
+    CHECK(regions.regions_intersecting(rc_coord{5,0}).empty());
+}
+
+#endif
@@ -86,4 +86,118 @@ TEST_CASE("region: combining operations", "region::unite, region::intersect, reg
     CHECK(m1.merge(m2) == m1m2);
 }
 
+TEST_CASE("region: window and wide storage", "region::add_cell, region::remove_safe, region::intersect, region::subtract") {
+    using namespace ms;
+
+    region near, far;
+
+    near.add_cell(rc_coord{5,5});
+    near.add_cell(rc_coord{4,6});
+    near.add_cell(rc_coord{6,4});
+    near.add_cell(rc_coord{3,3});
+    CHECK_FALSE(near.is_wide());
+    CHECK(near.size() == 4);
+    CHECK(near.contains(rc_coord{3,3}));
+    CHECK_FALSE(near.contains(rc_coord{3,4}));
+
+    far = near;
+    far.add_cell(rc_coord{20,5});
+    CHECK(far.is_wide());
+    CHECK(far.size() == 5);
+
+    //cells are visited in row major order in both modes
+    std::vector<rc_coord> expected{ {3,3},{4,6},{5,5},{6,4},{20,5} };
+    CHECK(std::vector<rc_coord>(far.begin(), far.end()) == expected);
+
+    far.set_count(2);
+    near.set_count(1);
+    region mixed = far.subtract(near);
+    CHECK(mixed.size() == 1);
+    CHECK(mixed.contains(rc_coord{20,5}));
+    CHECK_FALSE(mixed.is_wide());
+    CHECK(far.intersect(near).samearea(near));
+
+    //removing the far cell brings the region back into the window
+    far.remove_safe(rc_coord{20,5});
+    CHECK_FALSE(far.is_wide());
+    CHECK(far.samearea(near));
+
+    //removing the corner moves the anchor, but areas still compare equal
+    region moved;
+    moved.add_cell(rc_coord{6,4});
+    moved.add_cell(rc_coord{5,5});
+    moved.add_cell(rc_coord{4,6});
+    near.remove_safe(rc_coord{3,3});
+    CHECK(near.samearea(moved));
+    CHECK(near.has_intersect(moved));
+}
+
+TEST_CASE("region: split bounds", "region::split, region::count_common") {
+    using namespace ms;
+
+    region r1, r2;
+
+    r1.add_cell(rc_coord{1,1});
+    r1.add_cell(rc_coord{1,2});
+    r1.add_cell(rc_coord{2,1});
+    r1.set_count(2);
+
+    r2.add_cell(rc_coord{1,2});
+    r2.add_cell(rc_coord{2,1});
+    r2.add_cell(rc_coord{2,2});
+    r2.add_cell(rc_coord{3,3});
+    r2.set_range(1,3);
+
+    CHECK(r1.count_common(r2) == 2);
+
+    region_split bounds = r1.split(r2);
+    region common = r1.intersect(r2);
+    region this_only = r1.subtract(r2);
+    region arg_only = r2.subtract(r1);
+
+    CHECK(bounds.common.size == common.size());
+    CHECK(bounds.common.min == common.min());
+    CHECK(bounds.common.max == common.max());
+    CHECK(bounds.this_only.size == this_only.size());
+    CHECK(bounds.this_only.min == this_only.min());
+    CHECK(bounds.this_only.max == this_only.max());
+    CHECK(bounds.arg_only.size == arg_only.size());
+    CHECK(bounds.arg_only.min == arg_only.min());
+    CHECK(bounds.arg_only.max == arg_only.max());
+    CHECK(bounds.this_only.is_helpful() == this_only.is_helpful());
+}
+
+TEST_CASE("region: hash", "region::hash") {
+    using namespace ms;
+
+    region r1, r2;
+    r1.add_cell(rc_coord{4,4});
+    r1.add_cell(rc_coord{5,3});
+    r1.add_cell(rc_coord{5,5});
+    r2.add_cell(rc_coord{5,5});
+    r2.add_cell(rc_coord{5,3});
+    r2.add_cell(rc_coord{4,4});
+    r2.set_count(2);
+    CHECK(r1.hash() == r2.hash());
+
+    r2.remove_safe(rc_coord{4,4});
+    CHECK(r1.hash() != r2.hash());
+
+    //the hash of a wide region follows cells being added and removed
+    region w1 = r1, w2 = r1;
+    w1.add_cell(rc_coord{30,30});
+    w1.add_cell(rc_coord{40,0});
+    w2.add_cell(rc_coord{40,0});
+    w2.add_cell(rc_coord{30,30});
+    CHECK(w1.is_wide());
+    CHECK(w1.hash() == w2.hash());
+    w1.remove_safe(rc_coord{30,30});
+    CHECK(w1.hash() != w2.hash());
+    w2.remove_safe(rc_coord{30,30});
+    CHECK(w1.hash() == w2.hash());
+    w1.remove_safe(rc_coord{40,0});
+    CHECK_FALSE(w1.is_wide());
+    CHECK(w1.hash() == r1.hash());
+}
+
 #endif
\ No newline at end of file
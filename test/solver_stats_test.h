@@ -0,0 +1,64 @@
+#ifndef MS_TEST_SOLVER_STATS_TEST_H
+#define MS_TEST_SOLVER_STATS_TEST_H
+
+#include <catch.hpp>
+#include <string>
+#include "../solver_stats.h"
+#include "../solver.h"
+
+TEST_CASE("solver_stats: counting, merging and json", "solver_stats::count, solver_stats::merge, solver_stats::to_json") {
+    using namespace ms;
+
+    solver_stats stats, other;
+    stats.count(solver_stats::AUX_PAIRS, 5);
+    stats.count(solver_stats::AUX_PAIRS);
+    { solver_stats::timer timed(stats, solver_stats::FILL_QUEUE); }
+    { solver_stats::timer timed(stats, solver_stats::FILL_QUEUE); }
+    other.count(solver_stats::AUX_PAIRS, 4);
+    other.count(solver_stats::CHECKPOINTS, 2);
+    { solver_stats::timer timed(other, solver_stats::FILL_QUEUE); }
+
+    CHECK(stats.get(solver_stats::AUX_PAIRS) == 6);
+    CHECK(stats.get(solver_stats::FILL_QUEUE).calls == 2);
+    CHECK(stats.get(solver_stats::ENDGAME).calls == 0);
+
+    stats.merge(other);
+    CHECK(stats.get(solver_stats::AUX_PAIRS) == 10);
+    CHECK(stats.get(solver_stats::CHECKPOINTS) == 2);
+    CHECK(stats.get(solver_stats::FILL_QUEUE).calls == 3);
+
+    std::string json = stats.to_json();
+    CHECK(json.front() == '{');
+    CHECK(json.back() == '}');
+    CHECK(json.find("\"aux_pairs\":10") != std::string::npos);
+    CHECK(json.find("\"checkpoints\":2") != std::string::npos);
+    CHECK(json.find("\"fill_queue\":{\"calls\":3,\"nanoseconds\":") != std::string::npos);
+
+    stats.reset();
+    CHECK(stats.get(solver_stats::AUX_PAIRS) == 0);
+    CHECK(stats.get(solver_stats::FILL_QUEUE).calls == 0);
+    CHECK(stats.get(solver_stats::FILL_QUEUE).nanoseconds == 0);
+}
+
+TEST_CASE("solver_stats: the work of a game", "solver::stats, solver::reset_stats") {
+    using namespace ms;
+
+    solver ai(16,16,40);
+    ai.set_seed(3);
+    CHECK(ai.stats().get(solver_stats::FIND_BASE_REGIONS).calls == 0);
+    ai.solve();
+
+    const solver_stats& stats = ai.stats();
+    CHECK(stats.get(solver_stats::FIND_BASE_REGIONS).calls > 0);
+    CHECK(stats.get(solver_stats::BASE_REGIONS) > 0);
+    CHECK(stats.get(solver_stats::REGIONS_ADDED) > 0);
+    CHECK(stats.get(solver_stats::AUX_CANDIDATES_KEPT) <= stats.get(solver_stats::AUX_CANDIDATES));
+    CHECK(stats.get(solver_stats::CELLS_QUEUED) > 0);
+    //copies of the solver do not take its stats
+    CHECK(solver(ai, grid::SURFACE_COPY).stats().get(solver_stats::BASE_REGIONS) == 0);
+
+    ai.reset_stats();
+    CHECK(ai.stats().get(solver_stats::BASE_REGIONS) == 0);
+}
+
+#endif //MS_TEST_SOLVER_STATS_TEST_H
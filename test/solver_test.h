@@ -2,5 +2,205 @@
 #define MS_TEST_SOLVER_TEST_H
 
 #include <catch.hpp>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#include "../solver.h"
+#include "../game_runner.h"
 
-#endif
\ No newline at end of file
+namespace {
+
+    /**gives tests access to the hypothetical moves and regions of a solver**/
+    class probing_solver : public ms::solver {
+    public:
+        using ms::solver::solver;
+
+        /**Finds the payout of up to `most` hidden cells next to a number, which must leave the solver as it was.**/
+        void probe(unsigned most) {
+            for(unsigned row = 0; row < height() && most > 0; ++row) {
+                for(unsigned col = 0; col < width() && most > 0; ++col) {
+                    if(get(row,col) != ms::grid::ms_hidden || !next_to_number(row, col))
+                        continue;
+                    expected_payout(ms::rc_coord(row, col));
+                    --most;
+                }
+            }
+        }
+
+        /**Derives every region from the numbers on the grid again, without stopping at the first certain cell.**/
+        void derive_all() {
+            reset_regions();
+            find_base_regions();
+            find_aux_regions(false);
+        }
+
+        /**Plans a guess as `step` does in `LOOKAHEAD_GUESS` mode, without opening it.**/
+        ms::rc_coord plan() { return plan_guess(); }
+        /**Returns the positions stored by the last plan.**/
+        const ms::transposition_table& searched() const { return transpositions; }
+        std::set<ms::rc_coord> safe_cells() const { return safe_queue; }
+        std::set<ms::rc_coord> bomb_cells() const { return bomb_queue; }
+
+        /**Opens the cells certain to be safe until one has to be guessed. Returns false if the game ended first.**/
+        bool play_to_guess() {
+            while(gamestate() == ms::grid::RUNNING && step_certain() != ms::BAD_RC_COORD);
+            return gamestate() == ms::grid::RUNNING;
+        }
+
+        /**Returns every region as a string, in a fixed order.**/
+        std::vector<std::string> region_strings() const {
+            std::vector<std::string> ret;
+            for(const ms::region& reg : regions)
+                ret.push_back(reg.to_string());
+            std::sort(ret.begin(), ret.end());
+            return ret;
+        }
+
+    private:
+        bool next_to_number(unsigned row, unsigned col) const {
+            for(int dr = -1; dr <= 1; ++dr) {
+                for(int dc = -1; dc <= 1; ++dc) {
+                    int r = row + dr, c = col + dc;
+                    if(r >= 0 && c >= 0 && r < int(height()) && c < int(width()) && get(r,c) >= ms::grid::ms_1 && get(r,c) <= ms::grid::ms_8)
+                        return true;
+                }
+            }
+            return false;
+        }
+    };
+
+}
+
+TEST_CASE("solver: hypothetical moves leave the game unchanged", "solver::checkpoint, solver::rollback, solver::expected_payout") {
+    using namespace ms;
+
+    for(unsigned game = 0; game < 10; ++game) {
+        INFO("game " << game);
+        std::uint64_t seed = game_runner::game_seed(11, game);
+        probing_solver plain(16,30,99), probed(16,30,99);
+        plain.set_seed(seed);
+        probed.set_seed(seed);
+
+        std::vector<rc_coord> plain_moves, probed_moves;
+        for(rc_coord move = plain.step(); move != BAD_RC_COORD; move = plain.step())
+            plain_moves.push_back(move);
+        while(true) {
+            if(probed.gamestate() == grid::RUNNING)
+                probed.probe(4);
+            rc_coord move = probed.step();
+            if(move == BAD_RC_COORD)
+                break;
+            probed_moves.push_back(move);
+        }
+
+        CHECK(probed_moves == plain_moves);
+        CHECK(probed.gamestate() == plain.gamestate());
+    }
+}
+
+TEST_CASE("solver: the number of threads does not change the game", "solver::set_threads") {
+    using namespace ms;
+
+    for(unsigned game = 0; game < 6; ++game) {
+        INFO("game " << game);
+        std::uint64_t seed = game_runner::game_seed(9, game);
+        probing_solver single(16,30,99), multi(16,30,99);
+        single.set_seed(seed);
+        multi.set_seed(seed);
+        multi.set_threads(4);
+
+        //both are played in step, so the regions can be compared after every move
+        std::vector<rc_coord> single_moves, multi_moves;
+        std::vector<std::vector<std::string>> single_regions, multi_regions;
+        while(true) {
+            rc_coord single_move = single.step(), multi_move = multi.step();
+            single_moves.push_back(single_move);
+            multi_moves.push_back(multi_move);
+            single_regions.push_back(single.region_strings());
+            multi_regions.push_back(multi.region_strings());
+            if(single_move == BAD_RC_COORD || multi_move == BAD_RC_COORD || single_move != multi_move)
+                break;
+
+            //all regions derived at once are enough for the pairs to be split between the threads
+            if(single_moves.size() % 25 == 0) {
+                probing_solver single_derived(single.get_grid()), multi_derived(single.get_grid());
+                multi_derived.set_threads(4);
+                single_derived.derive_all();
+                multi_derived.derive_all();
+                single_regions.push_back(single_derived.region_strings());
+                multi_regions.push_back(multi_derived.region_strings());
+            }
+        }
+
+        CHECK(multi_moves == single_moves);
+        CHECK(multi_regions == single_regions);
+        CHECK(multi.gamestate() == single.gamestate());
+    }
+}
+
+TEST_CASE("solver: lookahead guesses", "solver::plan_guess, solver::lookahead") {
+    using namespace ms;
+
+    unsigned planned = 0;
+    for(unsigned game = 0; game < 4; ++game) {
+        INFO("game " << game);
+        probing_solver ai(16,30,99);
+        ai.set_seed(game_runner::game_seed(13, game));
+        ai.set_lookahead(2, std::chrono::seconds(60), 2);
+        ai.step();
+
+        for(unsigned guess = 0; guess < 3 && ai.play_to_guess(); ++guess) {
+            std::vector<std::string> regions = ai.region_strings();
+            std::set<rc_coord> safe = ai.safe_cells(), bombs = ai.bomb_cells();
+            std::uint64_t hash = ai.get_grid().hash();
+
+            rc_coord move = ai.plan();
+            REQUIRE(move != BAD_RC_COORD);
+            CHECK(ai.get(move.row, move.col) == grid::ms_hidden);
+            //the chance nodes stored the positions after the guess, and the finished search the position itself
+            float value;
+            CHECK(ai.searched().lookup(hash, 2, value));
+            CHECK(ai.searched().size() > 1);
+
+            CHECK(ai.region_strings() == regions);
+            CHECK(ai.safe_cells() == safe);
+            CHECK(ai.bomb_cells() == bombs);
+            CHECK(ai.get_grid().hash() == hash);
+            ++planned;
+            ai.manual_open(move);
+        }
+    }
+    CHECK(planned > 0);
+}
+
+TEST_CASE("solver: lookahead without time", "solver::plan_guess, solver::lookahead") {
+    using namespace ms;
+
+    probing_solver ai(16,30,99);
+    ai.set_seed(game_runner::game_seed(13, 0));
+    ai.step();
+    REQUIRE(ai.play_to_guess());
+    ai.set_lookahead(3, std::chrono::milliseconds(0));
+
+    //the search times out before any cell is searched, so the cell least likely to be a bomb is returned
+    const probability_map& probabilities = ai.get_probabilities();
+    rc_coord least = BAD_RC_COORD;
+    for(unsigned row = 0; row < ai.height(); ++row) {
+        for(unsigned col = 0; col < ai.width(); ++col) {
+            rc_coord cell(row, col);
+            if(ai.get(row,col) == grid::ms_hidden && (least == BAD_RC_COORD || probabilities.get(cell) < probabilities.get(least)))
+                least = cell;
+        }
+    }
+    std::uint64_t hash = ai.get_grid().hash();
+
+    CHECK(ai.plan() == least);
+    //timed out searches are not stored
+    float value;
+    CHECK_FALSE(ai.searched().lookup(hash, 1, value));
+    CHECK(ai.searched().size() == 0);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef MS_TEST_THREAD_POOL_TEST_H
+#define MS_TEST_THREAD_POOL_TEST_H
+
+#include <catch.hpp>
+#include <atomic>
+#include <stdexcept>
+#include "../thread_pool.h"
+
+TEST_CASE("thread_pool: parallel_for chunks", "thread_pool::parallel_for") {
+    using namespace ms;
+
+    for(unsigned threads : { 1u, 2u, 4u }) {
+        thread_pool pool(threads);
+        REQUIRE(pool.size() == std::max(threads, 1u));
+
+        for(size_t count : { size_t(0), size_t(3), size_t(1000) }) {
+            std::vector<unsigned> owner(count, pool.size());
+            std::vector<std::pair<size_t,size_t>> chunks(pool.size());
+            pool.parallel_for(count, [&](size_t begin, size_t end, unsigned worker) {
+                chunks[worker] = std::make_pair(begin, end);
+                for(size_t i = begin; i < end; ++i)
+                    owner[i] = worker;
+            });
+            //chunks are contiguous and in worker order
+            CHECK(chunks.front().first == 0);
+            CHECK(chunks.back().second == count);
+            for(unsigned worker = 1; worker < pool.size(); ++worker)
+                CHECK(chunks[worker].first == chunks[worker - 1].second);
+            CHECK(std::is_sorted(owner.begin(), owner.end()));
+            CHECK(std::count(owner.begin(), owner.end(), pool.size()) == 0);
+        }
+    }
+}
+
+TEST_CASE("thread_pool: nested calls and exceptions", "thread_pool::parallel_for") {
+    using namespace ms;
+
+    thread_pool pool(3);
+
+    std::atomic<size_t> total(0);
+    pool.parallel_for(30, [&](size_t begin, size_t end, unsigned) {
+        for(size_t i = begin; i < end; ++i) {
+            pool.parallel_for(10, [&](size_t b, size_t e, unsigned) { total += e - b; });
+        }
+    });
+    CHECK(total == 300);
+
+    CHECK_THROWS_AS(pool.parallel_for(30, [](size_t begin, size_t, unsigned) {
+        if(begin > 0)
+            throw std::runtime_error("chunk failed");
+    }), std::runtime_error);
+
+    //the pool can still be used after a chunk threw
+    total = 0;
+    pool.parallel_for(30, [&](size_t begin, size_t end, unsigned) { total += end - begin; });
+    CHECK(total == 30);
+}
+
+#endif
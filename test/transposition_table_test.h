@@ -0,0 +1,40 @@
+#ifndef MS_TEST_TRANSPOSITION_TABLE_TEST_H
+#define MS_TEST_TRANSPOSITION_TABLE_TEST_H
+
+#include <catch.hpp>
+#include "../transposition_table.h"
+
+TEST_CASE("transposition_table: store and look up positions", "transposition_table::store, transposition_table::lookup") {
+    using namespace ms;
+
+    transposition_table table(4);
+    CHECK(table.capacity() == 4);
+    float value = -1;
+    CHECK_FALSE(table.lookup(0, 1, value));
+
+    table.store(0, 2, 1.5f);
+    CHECK(table.lookup(0, 1, value));
+    CHECK(value == 1.5f);
+    CHECK(table.lookup(0, 2, value));
+    CHECK_FALSE(table.lookup(0, 3, value));
+    CHECK(table.size() == 1);
+
+    //key 4 shares the slot of key 0, and only replaces it if searched at least as deep
+    table.store(4, 1, 2.5f);
+    CHECK(table.lookup(0, 2, value));
+    CHECK_FALSE(table.lookup(4, 1, value));
+    table.store(4, 2, 2.5f);
+    CHECK_FALSE(table.lookup(0, 1, value));
+    CHECK(table.lookup(4, 2, value));
+    CHECK(value == 2.5f);
+    CHECK(table.size() == 1);
+
+    table.store(1, 1, 0.5f);
+    CHECK(table.size() == 2);
+    table.clear();
+    CHECK(table.size() == 0);
+    CHECK_FALSE(table.lookup(1, 1, value));
+    CHECK_FALSE(table.lookup(4, 1, value));
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+
+namespace ms {
+
+namespace {
+    /**true on threads that are running a chunk of some pool, so nested calls run inline**/
+    thread_local bool in_parallel_for = false;
+}
+
+/**
+ * Starts `threads - 1` worker threads. The calling thread of `parallel_for` is the last worker,
+ * so a pool of size one or zero starts no threads and runs everything on the caller.
+ **/
+thread_pool::thread_pool(unsigned threads) {
+    for(unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(&thread_pool::work, this, i);
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Splits `[0,count)` into `size()` contiguous chunks and calls `job(begin, end, worker)` for
+ * each of them, using the worker threads and the calling thread. Returns once all chunks are done.
+ * Chunks may be empty. If any chunk throws, one of the exceptions is rethrown once all chunks are done.
+ **/
+void thread_pool::parallel_for(size_t count, const job_type& job) {
+    if(workers.empty() || in_parallel_for) {
+        for(unsigned worker = 0; worker < size(); ++worker) {
+            job(count * worker / size(), count * (worker + 1) / size(), worker);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> serial(busy);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        this->job = &job;
+        this->count = count;
+        error = nullptr;
+        running = workers.size();
+        ++generation;
+    }
+    start_cv.notify_all();
+
+    run_chunk(0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    done_cv.wait(guard, [this] { return running == 0; });
+    this->job = nullptr;
+    if(error) {
+        std::exception_ptr rethrow = error;
+        error = nullptr;
+        std::rethrow_exception(rethrow);
+    }
+}
+
+void thread_pool::run_chunk(unsigned worker) {
+    in_parallel_for = true;
+    try {
+        (*job)(count * worker / size(), count * (worker + 1) / size(), worker);
+    } catch (...) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(!error)
+            error = std::current_exception();
+    }
+    in_parallel_for = false;
+}
+
+void thread_pool::work(unsigned worker) {
+    unsigned long seen = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            start_cv.wait(guard, [&] { return stopping || generation != seen; });
+            if(stopping)
+                return;
+            seen = generation;
+        }
+        run_chunk(worker);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            --running;
+        }
+        done_cv.notify_one();
+    }
+}
+
+}
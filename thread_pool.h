@@ -0,0 +1,62 @@
+#ifndef MS_THREAD_POOL_H
+#define MS_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ms {
+
+/**
+ * A fixed set of worker threads that run the chunks of a `parallel_for` together with the
+ * calling thread.
+ *
+ * The range given to `parallel_for` is split into `size()` contiguous chunks, and chunk `i` is
+ * always run as worker `i`, so a caller that writes the output of each worker to its own buffer
+ * and joins the buffers in worker order gets the same result as a serial loop, no matter how
+ * the threads were scheduled.
+ *
+ * A `parallel_for` started from inside a worker (or while another `parallel_for` is running on
+ * the same pool) runs all of its chunks on the calling thread.
+ **/
+class thread_pool {
+public:
+    /**function run on each chunk, taking the chunk's `begin`, `end` and worker index**/
+    typedef std::function<void(size_t, size_t, unsigned)> job_type;
+
+    explicit thread_pool(unsigned threads);
+    ~thread_pool();
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /**Returns the number of threads that run chunks, including the calling thread.\n Complexity \f$O(1)\f$**/
+    unsigned size() const { return workers.size() + 1; }
+
+    void parallel_for(size_t count, const job_type& job);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable start_cv, done_cv;
+    /**serializes calls to `parallel_for` from different threads**/
+    std::mutex busy;
+
+    const job_type* job = nullptr;
+    size_t count = 0;
+    /**incremented each time a job is started, so workers can tell a new job from a spurious wakeup**/
+    unsigned long generation = 0;
+    unsigned running = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void work(unsigned worker);
+    void run_chunk(unsigned worker);
+};
+
+}
+
+#endif //MS_THREAD_POOL_H
@@ -0,0 +1,60 @@
+#include "transposition_table.h"
+#include <algorithm>
+
+namespace ms {
+
+/**
+ * Initializes an empty table holding up to `capacity` positions, rounded up to a power of two.
+ **/
+transposition_table::transposition_table(size_t capacity) {
+    size_t rounded = 1;
+    while(rounded < capacity)
+        rounded <<= 1;
+    mask = rounded - 1;
+}
+
+/**
+ * Sets `value` to the value of the position with hash `key`, if it was stored searched to at
+ * least `depth`. Returns false, leaving `value` unchanged, if it was not.
+ *
+ * Complexity \f$O(1)\f$
+ **/
+bool transposition_table::lookup(std::uint64_t key, unsigned depth, float& value) const {
+    if(entries.empty())
+        return false;
+    const entry& e = entries[slot_of(key)];
+    if(e.depth == 0 || e.depth < depth || e.key != key)
+        return false;
+    value = e.value;
+    return true;
+}
+
+/**
+ * Stores the value of the position with hash `key` searched to `depth`, which must be at least 1.
+ * A different position searched deeper in the same slot is kept instead.
+ *
+ * Complexity \f$O(1)\f$, or \f$O(C)\f$ for the first call, where \f$C\f$ is the capacity
+ **/
+void transposition_table::store(std::uint64_t key, unsigned depth, float value) {
+    if(entries.empty())
+        entries.assign(mask + 1, entry{ 0, 0, 0 });
+    entry& e = entries[slot_of(key)];
+    if(e.depth == 0)
+        ++stored;
+    else if(e.key != key && e.depth > depth)
+        return;
+    e = entry{ key, value, depth };
+}
+
+/**
+ * Removes every position.
+ *
+ * Complexity \f$O(C)\f$ where \f$C\f$ is the capacity
+ **/
+void transposition_table::clear() {
+    if(stored > 0)
+        std::fill(entries.begin(), entries.end(), entry{ 0, 0, 0 });
+    stored = 0;
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef MS_TRANSPOSITION_TABLE_H
+#define MS_TRANSPOSITION_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ms {
+
+/**
+ * A fixed size cache of the values of positions searched by the lookahead planner, keyed by the
+ * hash of the visible grid (see `grid::hash`) and the depth the position was searched to.
+ *
+ * Each key has a single slot (the table is direct mapped), and a slot holding a position searched
+ * deeper is only replaced by a position searched at least as deep. Memory is not allocated until
+ * the first `store`.
+ **/
+class transposition_table {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+    explicit transposition_table(size_t capacity = DEFAULT_CAPACITY);
+
+    bool lookup(std::uint64_t key, unsigned depth, float& value) const;
+    void store(std::uint64_t key, unsigned depth, float value);
+    void clear();
+
+    /**Returns the number of positions stored.\n Complexity \f$O(1)\f$**/
+    size_t size() const { return stored; }
+    /**Returns the most positions that can be stored at once.\n Complexity \f$O(1)\f$**/
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct entry {
+        std::uint64_t key;
+        float value;
+        /**the depth the position was searched to, 0 if the slot is empty**/
+        unsigned depth;
+    };
+
+    std::vector<entry> entries;
+    size_t mask;
+    size_t stored = 0;
+
+    size_t slot_of(std::uint64_t key) const { return (key ^ (key >> 32)) & mask; }
+};
+
+}
+
+#endif //MS_TRANSPOSITION_TABLE_H
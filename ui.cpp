@@ -3,6 +3,7 @@
 #include <thread>
 #include <stdexcept>
 #include <iostream>
+#include <cstdio>
 #include <signal.h>
 
 namespace ms {
@@ -12,6 +13,7 @@ namespace ms {
     static int cursorx = 0;
     static int cursory = 0;
     static bool had_stopped = false; //redrawing within the sigcont handler failed, this is a workaround
+    static bool show_stats = false;
 
     static char cell_to_char(ms::grid::cell c) {
         switch(c) {
@@ -58,6 +60,21 @@ namespace ms {
         wmove(stdscr,basey + cursory + 1,basex + 2*cursorx + 2);
     }
 
+    //the time spent in each phase of the solver, below the grid
+    static void draw_stats(int basex, int basey) {
+        const solver_stats& stats = active_window->stats();
+        for(unsigned p = 0; p < solver_stats::PHASE_COUNT; ++p) {
+            const solver_stats::phase_totals& totals = stats.get(solver_stats::phase(p));
+            char line[64];
+            snprintf(line, sizeof(line), "%-18s %8llu calls %10.1f ms", solver_stats::name(solver_stats::phase(p)),
+                (unsigned long long) totals.calls, totals.nanoseconds / 1e6);
+            move(basey + p, basex);
+            clrtoeol();
+            if(show_stats)
+                addstr(line);
+        }
+    }
+
     static void draw_ui(bool redraw) {
         int maxx = getmaxx(stdscr);
         int maxy = getmaxy(stdscr);
@@ -105,6 +122,7 @@ namespace ms {
                 mvaddch(basey + row + 1, basex + col * 2 + 2, cell_to_char(active_window->get(row,col)));
             }
         }
+        draw_stats(basex, basey + height + 3);
         wmove(stdscr,basey + cursory + 1,basex + 2*cursorx + 2);
     }
 
@@ -194,6 +212,11 @@ namespace ms {
                 active_window->solve();
                 draw_ui(false);
                 break;
+            case 'i':
+            case 'I':
+                show_stats = !show_stats;
+                draw_ui(false);
+                break;
             case 'f':
             case 'F':
                 if(active_window->gamestate() != grid::NEW && active_window->gamestate() != grid::RUNNING)